@@ -0,0 +1,131 @@
+/*
+ * arena.c - This file contains the arena (bump allocator) of the assembler context.
+ * The nodes and strings of a file (labels, interned names, macros and their content) are all carved
+ * out of a few large blocks owned by the context, instead of a malloc for every one of them.
+ * Nothing is freed one by one: the whole arena is reset in O(1) between files, and its blocks are
+ * reused by the next file of the same context.
+ */
+
+#include "assembler.h"
+
+
+#define ARENA_ALIGN 8 /* every allocation starts at a multiple of 8 bytes */
+
+/* the data of a block starts right after its header */
+#define BLOCK_HEADER_SIZE ((sizeof(arena_block) + ARENA_ALIGN - 1) & ~(size_t) (ARENA_ALIGN - 1))
+#define BLOCK_DATA(block) ((char *) (block) + BLOCK_HEADER_SIZE)
+
+
+/*
+ * newBlock - Allocates a new empty block.
+ * @size: The num of bytes that can be allocated from the block.
+ *
+ * Return: The new block, NULL on memory error.
+ */
+static arena_block *newBlock(size_t size)
+{
+	arena_block *block = (arena_block *) malloc(BLOCK_HEADER_SIZE + size);
+	TABLE_GROWTH();
+	if (block == NULL) {
+		return NULL;
+	}
+	block -> next = NULL;
+	block -> size = size;
+	block -> used = 0;
+	return block;
+}
+
+
+/*
+ * arenaAlloc - Allocates memory from an arena.
+ * @a: The arena.
+ * @size: The num of bytes to be allocated.
+ *
+ * The memory is taken from the current block, or from the next one when it doesn't fit.
+ * A block that was left by an earlier reset is reused before a new block is allocated.
+ *
+ * Return: The allocated memory (not initialized), NULL on memory error.
+ */
+void *arenaAlloc(arena *a, size_t size)
+{
+	arena_block *block = a -> current;
+	void *p;
+
+	size = (size + ARENA_ALIGN - 1) & ~(size_t) (ARENA_ALIGN - 1);
+
+	if (block == NULL || block -> used + size > block -> size) {
+		if (block != NULL && block -> next != NULL && block -> next -> size >= size) {
+			block = block -> next; /* reuse the next block */
+		} else {
+			arena_block *new_block = newBlock(size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE);
+			if (new_block == NULL) {
+				return NULL; /* memory error */
+			}
+
+			/* put the new block right after the current one, the blocks after it are still reused later */
+			if (block == NULL) {
+				new_block -> next = a -> first;
+				a -> first = new_block;
+			} else {
+				new_block -> next = block -> next;
+				block -> next = new_block;
+			}
+			block = new_block;
+		}
+		block -> used = 0;
+		a -> current = block;
+	}
+
+	p = BLOCK_DATA(block) + block -> used;
+	block -> used += size;
+	return p;
+}
+
+
+/*
+ * arenaCopy - Copies a string into an arena.
+ * @a: The arena.
+ * @s: The string to be copied.
+ *
+ * Return: The copy, NULL on memory error.
+ */
+char *arenaCopy(arena *a, const char *s)
+{
+	size_t length = strlen(s) + 1;
+	char *copy = (char *) arenaAlloc(a, length);
+	if (copy != NULL) {
+		memcpy(copy, s, length);
+	}
+	return copy;
+}
+
+
+/*
+ * resetArena - Frees everything that was allocated from an arena at once.
+ * @a: The arena.
+ *
+ * The blocks themselves are kept for the next allocations.
+ */
+void resetArena(arena *a)
+{
+	a -> current = a -> first;
+	if (a -> first != NULL) {
+		a -> first -> used = 0;
+	}
+}
+
+
+/*
+ * freeArena - Frees all the blocks of an arena.
+ * @a: The arena.
+ */
+void freeArena(arena *a)
+{
+	arena_block *block = a -> first;
+	while (block != NULL) {
+		arena_block *next = block -> next;
+		free(block);
+		block = next;
+	}
+	a -> first = a -> current = NULL;
+}
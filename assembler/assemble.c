@@ -0,0 +1,787 @@
+/*
+ * assemble.c - This file contains the in-process interface of the assembler.
+ * It runs the same stages as "runfile" (pre-assembler, first stage and second stage) on a source
+ * text in memory, in a context of its own, and returns the final memory image, the entries, the
+ * externs and the diagnostics in an "asm_result" instead of writing the output files.
+ * An incremental session keeps the source split into segments of lines, with the results of the pre-assembler
+ * and the first stage of every segment, so after an edit only the segments of the edited lines are processed
+ * again, the rest are just merged again at their new addresses (and the second stage resolves the labels).
+ */
+
+#include <limits.h>
+#include "assembler.h"
+#include "excess_macro_list.h"
+#include "assemble.h"
+#include "../pre_processing/macros_table.h"
+#include "../pre_processing/pre_assembler.h"
+
+#define ASSEMBLE_DEFAULT_NAME "input" /* the name of the source in the diagnostics */
+#define SESSION_SEGMENT_LINES 64 /* the max num of source lines in a segment of a session */
+
+
+/*
+ * copyString - Returns a malloc-ed copy of a given string, NULL on memory error.
+ */
+static char *copyString(const char *s)
+{
+	char *copy = (char *) malloc(strlen(s) + 1);
+	if (copy != NULL) {
+		strcpy(copy, s);
+	}
+	return copy;
+}
+
+
+/*
+ * collectResult - Copies the memory image, the entries and the externs of the current context into a result.
+ * @result: The result to be filled.
+ *
+ * Return: 1 on success, 0 on memory error.
+ */
+static int collectResult(asm_result *result)
+{
+	int total_cells = Ctx -> instruction_image.size + Ctx -> data_image.size;
+	int num_of_entries = Ctx -> output_plan.num_of_entries;
+	int i;
+
+	/* the memory image, from address FIRST_ADDRESS */
+	result -> IC = Ctx -> instruction_image.size;
+	result -> DC = Ctx -> data_image.size;
+	result -> words = (unsigned short *) malloc((total_cells + 1) * sizeof(unsigned short));
+	if (result -> words == NULL) {
+		return 0;
+	}
+	for (i = 0; i < total_cells; i++) {
+		result -> words[i] = memoryWord(i + FIRST_ADDRESS) & 077777; /* 15-bit words, as in the .ob file */
+	}
+
+	/* the entry labels, as in the .ent file */
+	result -> entries = (asm_entry *) calloc(num_of_entries + 1, sizeof(asm_entry));
+	if (result -> entries == NULL) {
+		return 0;
+	}
+	for (i = 0; i < num_of_entries; i++) {
+		Lptr p = plannedEntry(i);
+		asm_entry *e = &result -> entries[result -> num_of_entries++];
+		e -> address = p -> value;
+		if ((e -> name = copyString(getName(p -> name_id))) == NULL) {
+			return 0;
+		}
+	}
+
+	/* the uses of the external labels, as in the .ext file (sorted by the output plan) */
+	result -> externs = (asm_extern *) calloc(Ctx -> extern_uses.size + 1, sizeof(asm_extern));
+	if (result -> externs == NULL) {
+		return 0;
+	}
+	for (i = 0; i < Ctx -> extern_uses.size; i++) {
+		asm_extern *e = &result -> externs[result -> num_of_externs++];
+		e -> address = Ctx -> extern_uses.items[i].address + FIRST_ADDRESS;
+		if ((e -> name = copyString(getName(Ctx -> extern_uses.items[i].name_id))) == NULL) {
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+
+/*
+ * finishAssemble - Runs the second stage on the current context, and fills a result from it.
+ * @file_name: The name of the source, used in the diagnostics.
+ * @err: The result of the stages before, the second stage runs only if it's 1.
+ * @result: The result to be filled.
+ *
+ * The diagnostics are handed over to the result, and the current context is freed (the caller restores Ctx).
+ *
+ * Return: 0 - regular error
+ *         1 - success
+ *         2 - memory error
+ */
+static int finishAssemble(char *file_name, int err, asm_result *result)
+{
+	if (err == 1) {
+		err = second_stage(file_name);
+	}
+	if (err == 1) {
+		int load_err = loadPCMemory();
+		if (load_err == 0) {
+			diagPrintf(DIAG_MEMORY_LIMIT, 0, "\nERROR: in file \"%s\", the memory image surpasses the memory limit of %d.\n", file_name, MEMORY_WORDS);
+		}
+		err = load_err; /* 1, 0 or 2 (memory error) */
+	}
+	if (err == 1 && collectResult(result) == 0) {
+		err = 2; /* memory error */
+	}
+
+	/* hand over the diagnostics */
+	result -> diagnostics = (Ctx -> log.text != NULL) ? Ctx -> log.text : copyString("");
+	Ctx -> log.text = NULL;
+
+	FREE_FILE_TABLES;
+	freeContext(Ctx);
+
+	if (result -> diagnostics == NULL) {
+		return 2; /* memory error */
+	}
+	return err;
+}
+
+
+/*
+ * assembleNamed - Assembles a source text in memory.
+ * @name: The name of the source, used in the diagnostics.
+ * @src: The source text, it doesn't have to be null-terminated.
+ * @len: The num of characters in the source text.
+ * @result: The result to be filled.
+ *
+ * Return: 0 - regular error
+ *         1 - success
+ *         2 - memory error
+ */
+int assembleNamed(const char *name, const char *src, size_t len, asm_result *result)
+{
+	asm_context *caller_ctx = Ctx; /* in case the caller is itself in the middle of a file */
+	char file_name[256];
+	int err;
+
+	memset(result, 0, sizeof(asm_result));
+
+	Ctx = newContext(1);
+	if (Ctx == NULL) {
+		Ctx = caller_ctx;
+		result -> diagnostics = copyString("");
+		return 2; /* memory error */
+	}
+
+	/* the name is only used in the diagnostics */
+	strncpy(file_name, name, sizeof(file_name) - 1);
+	file_name[sizeof(file_name) - 1] = '\0';
+	Ctx -> file_name = file_name;
+
+	/* run the stages, one after the other */
+	if (len > (size_t) INT_MAX) {
+		diagPrintf(DIAG_MEMORY_LIMIT, 0, "\nERROR: in file \"%s\", the source is too big.\n", file_name);
+		err = 0;
+	} else {
+		err = preAssembleText(src, (int) len, file_name);
+	}
+	if (err == 1) {
+		err = first_stage(file_name);
+	}
+	err = finishAssemble(file_name, err, result);
+
+	Ctx = caller_ctx;
+	return err;
+}
+
+
+/*
+ * assemble - Assembles a source text in memory (see assemble.h).
+ */
+int assemble(const char *src, size_t len, asm_result *result)
+{
+	return assembleNamed(ASSEMBLE_DEFAULT_NAME, src, len, result);
+}
+
+
+/*
+ * freeAsmResult - Frees everything in a result that was filled by "assemble".
+ * @result: The result to be freed.
+ */
+void freeAsmResult(asm_result *result)
+{
+	int i;
+
+	if (result -> entries != NULL) {
+		for (i = 0; i < result -> num_of_entries; i++) {
+			free(result -> entries[i].name);
+		}
+	}
+	if (result -> externs != NULL) {
+		for (i = 0; i < result -> num_of_externs; i++) {
+			free(result -> externs[i].name);
+		}
+	}
+	free(result -> words);
+	free(result -> entries);
+	free(result -> externs);
+	free(result -> diagnostics);
+	memset(result, 0, sizeof(asm_result));
+}
+
+
+/* (-----Incremental sessions: a source that's edited again and again, and assembled after every edit-----) */
+
+/* this struct defines a segment of the source of a session, the results of its stages are kept between the edits */
+typedef struct {
+	char *source; /* the lines of the segment, not null-terminated */
+	int size; /* num of characters in the lines */
+	int num_of_lines;
+	int line_num; /* num of source lines before the segment, when it was pre-assembled */
+	int am_lines; /* num of lines of its expanded source */
+	asm_context *pre_ctx; /* its expanded source and the messages of the pre-assembler, NULL until it's pre-assembled */
+	int pre_result; /* the result of the pre-assembler */
+	stage_chunk chunk; /* its first stage, "chunk.ctx" is NULL until it's processed */
+} session_segment;
+
+struct asm_session {
+	char name[256]; /* the name of the source, used in the diagnostics */
+	session_segment *segments; /* in the order of the source */
+	int num_of_segments;
+	int segments_capacity;
+};
+
+
+/*
+ * countLines - Returns the num of lines of a text (the last line doesn't need a '\n').
+ */
+static int countLines(const char *text, int size)
+{
+	int num_of_lines = 0;
+	int pos = 0;
+	line_view view;
+
+	while (nextLine(text, size, &pos, &view)) {
+		num_of_lines++;
+	}
+	return num_of_lines;
+}
+
+
+/*
+ * linePosition - Returns the position of a line of a text (the size of the text past its last line).
+ * @text: The text.
+ * @size: The num of characters in the text.
+ * @line: The num of lines before the line.
+ */
+static int linePosition(const char *text, int size, int line)
+{
+	int pos = 0;
+	line_view view;
+
+	while (line > 0 && nextLine(text, size, &pos, &view)) {
+		line--;
+	}
+	return pos;
+}
+
+
+/*
+ * dropSegmentStages - Frees the results of the stages of a segment, its lines are kept.
+ * @seg: The segment.
+ */
+static void dropSegmentStages(session_segment *seg)
+{
+	asm_context *caller_ctx = Ctx;
+
+	freeChunkContext(seg -> chunk.ctx); /* before the expanded source it shares */
+	seg -> chunk.ctx = NULL;
+	if (seg -> pre_ctx != NULL) {
+		Ctx = seg -> pre_ctx;
+		FREE_FILE_TABLES;
+		Ctx = caller_ctx;
+		freeContext(seg -> pre_ctx);
+		seg -> pre_ctx = NULL;
+	}
+}
+
+
+/*
+ * splitSegments - Splits a text into new segments of SESSION_SEGMENT_LINES lines (at most).
+ * @text: The text.
+ * @size: The num of characters in the text.
+ * @num_of_segments: Filled with the num of new segments.
+ *
+ * Return: The new segments (nothing is processed yet), NULL on memory error.
+ */
+static session_segment *splitSegments(const char *text, int size, int *num_of_segments)
+{
+	int num_of_lines = countLines(text, size);
+	int n = (num_of_lines + SESSION_SEGMENT_LINES - 1) / SESSION_SEGMENT_LINES;
+	session_segment *segments = (session_segment *) calloc(n + 1, sizeof(session_segment));
+	int pos = 0;
+	int i;
+
+	if (segments == NULL) {
+		return NULL;
+	}
+	for (i = 0; i < n; i++) {
+		session_segment *seg = &segments[i];
+		int end = pos + linePosition(text + pos, size - pos, SESSION_SEGMENT_LINES);
+
+		seg -> size = end - pos;
+		seg -> num_of_lines = (i < n - 1) ? SESSION_SEGMENT_LINES : num_of_lines - i * SESSION_SEGMENT_LINES;
+		seg -> source = (char *) malloc(seg -> size + 1);
+		if (seg -> source == NULL) {
+			while (i-- > 0) {
+				free(segments[i].source);
+			}
+			free(segments);
+			return NULL;
+		}
+		memcpy(seg -> source, text + pos, seg -> size);
+		pos = end;
+	}
+
+	*num_of_segments = n;
+	return segments;
+}
+
+
+/*
+ * replaceSegments - Replaces a range of segments of a session by new segments.
+ * @session: The session.
+ * @first: The index of the first segment to be replaced.
+ * @count: The num of segments to be replaced.
+ * @text: The text of the new segments.
+ * @size: The num of characters in the text.
+ *
+ * Nothing is changed on memory error.
+ *
+ * Return: 1 on success, 0 on memory error.
+ */
+static int replaceSegments(asm_session *session, int first, int count, const char *text, int size)
+{
+	session_segment *new_segments;
+	int num_of_new = 0;
+	int total;
+	int i;
+
+	new_segments = splitSegments(text, size, &num_of_new);
+	if (new_segments == NULL) {
+		return 0;
+	}
+
+	/* make room for the new segments */
+	total = session -> num_of_segments - count + num_of_new;
+	if (total > session -> segments_capacity) {
+		int new_capacity = (session -> segments_capacity == 0) ? num_of_new : session -> segments_capacity * 2;
+		session_segment *grown;
+
+		if (new_capacity < total) {
+			new_capacity = total;
+		}
+		grown = (session_segment *) realloc(session -> segments, new_capacity * sizeof(session_segment));
+		if (grown == NULL) {
+			for (i = 0; i < num_of_new; i++) {
+				free(new_segments[i].source);
+			}
+			free(new_segments);
+			return 0;
+		}
+		session -> segments = grown;
+		session -> segments_capacity = new_capacity;
+	}
+
+	/* the replaced segments are freed, the segments after them move into their place */
+	for (i = first; i < first + count; i++) {
+		dropSegmentStages(&session -> segments[i]);
+		free(session -> segments[i].source);
+	}
+	memmove(&session -> segments[first + num_of_new], &session -> segments[first + count],
+		(session -> num_of_segments - first - count) * sizeof(session_segment));
+	memcpy(&session -> segments[first], new_segments, num_of_new * sizeof(session_segment));
+	session -> num_of_segments = total;
+
+	free(new_segments);
+	return 1;
+}
+
+
+/*
+ * preAssembleSegment - Runs the pre-assembler on the lines of a segment, in a context of its own.
+ * @session: The session.
+ * @seg: The segment.
+ * @line_num: The num of source lines before the segment.
+ *
+ * Return: 1 on success, 0 on memory error.
+ */
+static int preAssembleSegment(asm_session *session, session_segment *seg, int line_num)
+{
+	asm_context *caller_ctx = Ctx;
+
+	dropSegmentStages(seg);
+	seg -> pre_ctx = newContext(1);
+	if (seg -> pre_ctx == NULL) {
+		return 0;
+	}
+	seg -> pre_ctx -> file_name = session -> name;
+	seg -> line_num = line_num;
+
+	Ctx = seg -> pre_ctx;
+	seg -> pre_result = preAssembleLines(seg -> source, seg -> size, session -> name, line_num);
+	seg -> am_lines = countLines(Ctx -> am_buffer.text, Ctx -> am_buffer.size);
+	Ctx = caller_ctx;
+	return 1;
+}
+
+
+/*
+ * stageSegment - Runs the first stage on the expanded source of a segment, as a chunk of the first stage.
+ * @session: The session.
+ * @seg: The segment.
+ * @line_num: The num of lines of the expanded source before the segment.
+ *
+ * Return: 1 on success, 0 on memory error.
+ */
+static int stageSegment(asm_session *session, session_segment *seg, int line_num)
+{
+	asm_context *caller_ctx = Ctx;
+
+	freeChunkContext(seg -> chunk.ctx);
+	memset(&seg -> chunk, 0, sizeof(stage_chunk));
+	seg -> chunk.ctx = newChunkContext(seg -> pre_ctx);
+	if (seg -> chunk.ctx == NULL) {
+		return 0;
+	}
+	seg -> chunk.file_name = session -> name;
+	seg -> chunk.end = seg -> pre_ctx -> am_buffer.size;
+	seg -> chunk.line_num = line_num;
+
+	runChunk(&seg -> chunk);
+	Ctx = caller_ctx;
+	return 1;
+}
+
+
+/*
+ * stageSession - Handles the first stage of a session, in the context of the file.
+ * @session: The session.
+ * @whole: Turned on if the source is to be assembled as a whole instead (the messages are dropped then).
+ *
+ * Every segment is a chunk of the first stage (see first_stage_chunks.c), only the segments that were edited
+ * are processed again, and the segments whose messages have moved to other lines. The chunks are then merged
+ * in order, the others just move by the lines and the words before them.
+ * The first stage stops at the very line that surpasses the memory limit, and skips the whole line of a label
+ * that's already defined, so a source that surpasses the limit, or that has a label of one segment defined
+ * again by another (any message of the merge), is left to be assembled as a whole.
+ *
+ * Return: 0 - regular error
+ *         1 - success
+ *         2 - memory error
+ */
+static int stageSession(asm_session *session, int *whole)
+{
+	int err_count = 0;
+	int IC = 0, DC = 0;
+	int line_num = 0;
+	int i;
+
+	for (i = 0; i < session -> num_of_segments; i++) {
+		session_segment *seg = &session -> segments[i];
+		stage_chunk *chunk = &seg -> chunk;
+		int num_of_messages; /* the messages of the file once the messages of the chunk are appended */
+		int merge_err;
+
+		if (chunk -> ctx == NULL || chunk -> result == 2 || (chunk -> line_num != line_num && chunk -> ctx -> diagnostics.count > 0)) {
+			if (stageSegment(session, seg, line_num) == 0) {
+				diagPrintf(DIAG_NO_MEMORY, 0, "\nERROR: in file %s, unable to allocate memory for the first stage.\n", session -> name);
+				return 2; /* memory error */
+			}
+		}
+		chunk -> line_offset = line_num - chunk -> line_num;
+		line_num += seg -> am_lines;
+
+		if (chunk -> result == 2) {
+			appendLog(chunk -> ctx); /* the memory error of the chunk */
+			return 2;
+		}
+		num_of_messages = Ctx -> diagnostics.count + chunk -> ctx -> diagnostics.count;
+		merge_err = mergeChunk(chunk, IC, DC);
+		if (merge_err == 2) {
+			return 2; /* memory error */
+		}
+		if (Ctx -> diagnostics.count > num_of_messages) {
+			*whole = 1;
+			return 0;
+		}
+		if (merge_err == 0) {
+			err_count++;
+		}
+		IC += chunk -> IC;
+		DC += chunk -> DC;
+
+		if (FIRST_ADDRESS + IC + DC > MEMORY_WORDS) {
+			*whole = 1;
+			return 0;
+		}
+	}
+
+	if (err_count > 0) {
+		return 0;
+	}
+
+	/* Update all ".data" & ".string" labels with IC+FIRST_ADDRESS, and update all .code labels with +FIRST_ADDRESS */
+	updateLabels(IC);
+
+	return 1; /* success */
+}
+
+
+/*
+ * assembleWholeSession - Assembles the whole source of a session at once, by "assembleNamed".
+ * @session: The session.
+ * @result: The result to be filled.
+ *
+ * Return: 0 - regular error
+ *         1 - success
+ *         2 - memory error
+ */
+static int assembleWholeSession(asm_session *session, asm_result *result)
+{
+	size_t size = 0;
+	char *src;
+	int err;
+	int i;
+
+	for (i = 0; i < session -> num_of_segments; i++) {
+		size += session -> segments[i].size;
+	}
+	src = (char *) malloc(size + 1);
+	if (src == NULL) {
+		memset(result, 0, sizeof(asm_result));
+		result -> diagnostics = copyString("");
+		return 2; /* memory error */
+	}
+	size = 0;
+	for (i = 0; i < session -> num_of_segments; i++) {
+		memcpy(src + size, session -> segments[i].source, session -> segments[i].size);
+		size += session -> segments[i].size;
+	}
+
+	err = assembleNamed(session -> name, src, size, result);
+	free(src);
+	return err;
+}
+
+
+/*
+ * assembleSession - Assembles the source of a session, by the results of the segments that are still valid.
+ * @session: The session.
+ * @result: The result to be filled.
+ *
+ * The pre-assembler runs on a segment that was edited, or whose messages have moved to other lines. A source
+ * with macros (or macro libraries) and a run with "--max-errors" are assembled as a whole, since a segment
+ * can't be expanded (nor its errors counted) on its own then, and so are some sources with errors (see stageSession).
+ *
+ * Return: 0 - regular error
+ *         1 - success
+ *         2 - memory error
+ */
+static int assembleSession(asm_session *session, asm_result *result)
+{
+	asm_context *caller_ctx = Ctx; /* in case the caller is itself in the middle of a file */
+	int whole = (MAX_ERRORS > 0);
+	int line_num = 0;
+	int err = 1;
+	int i;
+
+	memset(result, 0, sizeof(asm_result));
+
+	/* --(pre-assemble the segments)-- */
+	for (i = 0; i < session -> num_of_segments; i++) {
+		session_segment *seg = &session -> segments[i];
+
+		if (seg -> pre_ctx == NULL || seg -> pre_result == 2 || (seg -> line_num != line_num && seg -> pre_ctx -> diagnostics.count > 0)) {
+			if (preAssembleSegment(session, seg, line_num) == 0) {
+				result -> diagnostics = copyString("");
+				return 2; /* memory error */
+			}
+		}
+		if (seg -> pre_ctx -> macros.list != NULL || seg -> pre_ctx -> macros.num_of_libraries > 0) {
+			whole = 1;
+		}
+		line_num += seg -> num_of_lines;
+	}
+	if (whole == 1) {
+		return assembleWholeSession(session, result);
+	}
+
+	Ctx = newContext(1);
+	if (Ctx == NULL) {
+		Ctx = caller_ctx;
+		result -> diagnostics = copyString("");
+		return 2; /* memory error */
+	}
+	Ctx -> file_name = session -> name;
+
+	/* the messages of the pre-assembler, in order */
+	for (i = 0; i < session -> num_of_segments; i++) {
+		session_segment *seg = &session -> segments[i];
+
+		appendLog(seg -> pre_ctx);
+		if (seg -> pre_result == 2) {
+			err = 2;
+		}
+		else if (seg -> pre_result == 0 && err == 1) {
+			err = 0;
+		}
+	}
+
+	if (err == 1) {
+		err = stageSession(session, &whole);
+	}
+	if (whole == 1) {
+		FREE_FILE_TABLES;
+		freeContext(Ctx);
+		Ctx = caller_ctx;
+		return assembleWholeSession(session, result);
+	}
+	err = finishAssemble(session -> name, err, result);
+
+	Ctx = caller_ctx;
+	return err;
+}
+
+
+/*
+ * newSession - Creates an incremental session (see assemble.h).
+ * @name: The name of the source, used in the diagnostics.
+ *
+ * Return: The new session, NULL on memory error.
+ */
+asm_session *newSession(const char *name)
+{
+	asm_session *session = (asm_session *) calloc(1, sizeof(asm_session));
+
+	if (session != NULL) {
+		strncpy(session -> name, name, sizeof(session -> name) - 1);
+	}
+	return session;
+}
+
+
+/*
+ * sessionAssemble - Assembles a new source in a session, the results of the old source are dropped.
+ * @session: The session.
+ * @src: The source text, it doesn't have to be null-terminated.
+ * @len: The num of characters in the source text.
+ * @result: The result to be filled.
+ *
+ * Return: 0 - regular error
+ *         1 - success
+ *         2 - memory error
+ */
+int sessionAssemble(asm_session *session, const char *src, size_t len, asm_result *result)
+{
+	if (len > (size_t) INT_MAX) {
+		return assembleNamed(session -> name, src, len, result); /* reports that the source is too big */
+	}
+	if (replaceSegments(session, 0, session -> num_of_segments, src, (int) len) == 0) {
+		memset(result, 0, sizeof(asm_result));
+		result -> diagnostics = copyString("");
+		return 2; /* memory error */
+	}
+	return assembleSession(session, result);
+}
+
+
+/*
+ * sessionEdit - Replaces a range of lines of the source of a session, and assembles it again.
+ * @session: The session.
+ * @first_line: The first line to be replaced (the first line of the source is 1).
+ * @num_of_lines: The num of lines to be replaced, 0 inserts the text before the first line.
+ * @text: The new lines, they don't have to be null-terminated.
+ * @len: The num of characters in the new lines.
+ * @result: The result to be filled.
+ *
+ * Only the segments of the edited lines are split again, the new lines end with a '\n' unless they're the end of the source.
+ *
+ * Return: 0 - regular error (also a range that's out of the source, reported in the diagnostics)
+ *         1 - success
+ *         2 - memory error
+ */
+int sessionEdit(asm_session *session, int first_line, int num_of_lines, const char *text, size_t len, asm_result *result)
+{
+	int total_lines = 0;
+	int first_seg, last_seg; /* the segments of the edited lines */
+	int first_seg_line = 0, last_seg_line = 0; /* num of lines before them */
+	int prefix_size, suffix_pos, suffix_size;
+	session_segment *first, *last;
+	char *joined;
+	int size = 0;
+	int replace_err;
+	int i;
+
+	for (i = 0; i < session -> num_of_segments; i++) {
+		total_lines += session -> segments[i].num_of_lines;
+	}
+	if (first_line < 1 || num_of_lines < 0 || first_line - 1 > total_lines - num_of_lines || len > (size_t) INT_MAX) {
+		char message[128 + sizeof(session -> name)];
+
+		memset(result, 0, sizeof(asm_result));
+		sprintf(message, "\nERROR: in file \"%s\", lines %d-%d are out of the source (%d lines).\n", session -> name, first_line, first_line + num_of_lines - 1, total_lines);
+		result -> diagnostics = copyString(message);
+		return (result -> diagnostics == NULL) ? 2 : 0;
+	}
+	if (session -> num_of_segments == 0) {
+		return sessionAssemble(session, text, len, result);
+	}
+
+	/* --(find the segments of the edited lines, inserting at the end of the source is done in the last segment)-- */
+	first_seg = 0;
+	while (first_seg < session -> num_of_segments - 1 && first_seg_line + session -> segments[first_seg].num_of_lines < first_line) {
+		first_seg_line += session -> segments[first_seg++].num_of_lines;
+	}
+	last_seg = first_seg;
+	last_seg_line = first_seg_line;
+	while (last_seg < session -> num_of_segments - 1 && last_seg_line + session -> segments[last_seg].num_of_lines < first_line + num_of_lines - 1) {
+		last_seg_line += session -> segments[last_seg++].num_of_lines;
+	}
+	first = &session -> segments[first_seg];
+	last = &session -> segments[last_seg];
+
+	/* --(join the lines of those segments before the range, the new lines and their lines after the range)-- */
+	prefix_size = linePosition(first -> source, first -> size, first_line - 1 - first_seg_line);
+	suffix_pos = linePosition(last -> source, last -> size, first_line - 1 + num_of_lines - last_seg_line);
+	suffix_size = last -> size - suffix_pos;
+
+	joined = (char *) malloc(prefix_size + len + suffix_size + 3);
+	if (joined == NULL) {
+		memset(result, 0, sizeof(asm_result));
+		result -> diagnostics = copyString("");
+		return 2; /* memory error */
+	}
+	memcpy(joined, first -> source, prefix_size);
+	size = prefix_size;
+	if (len > 0 && size > 0 && joined[size - 1] != '\n') {
+		joined[size++] = '\n'; /* lines added after the last line of the source */
+	}
+	memcpy(joined + size, text, len);
+	size += len;
+	if (len > 0 && text[len - 1] != '\n' && (suffix_size > 0 || last_seg < session -> num_of_segments - 1)) {
+		joined[size++] = '\n';
+	}
+	memcpy(joined + size, last -> source + suffix_pos, suffix_size);
+	size += suffix_size;
+
+	replace_err = replaceSegments(session, first_seg, last_seg - first_seg + 1, joined, size);
+	free(joined);
+	if (replace_err == 0) {
+		memset(result, 0, sizeof(asm_result));
+		result -> diagnostics = copyString("");
+		return 2; /* memory error */
+	}
+	return assembleSession(session, result);
+}
+
+
+/*
+ * freeSession - Frees an incremental session and everything it keeps.
+ * @session: The session (may be NULL).
+ */
+void freeSession(asm_session *session)
+{
+	int i;
+
+	if (session == NULL) {
+		return;
+	}
+	for (i = 0; i < session -> num_of_segments; i++) {
+		dropSegmentStages(&session -> segments[i]);
+		free(session -> segments[i].source);
+	}
+	free(session -> segments);
+	free(session);
+}
@@ -0,0 +1,104 @@
+/*
+ * assemble.h - The in-process interface of the assembler (libassembler.a)
+ * This header file is all a program needs in order to assemble a source text in memory, without
+ * the "runfile" binary and without any files: the source is passed as a buffer, and the memory
+ * image, the entry labels, the uses of the external labels and the diagnostics are returned in
+ * an "asm_result".
+ * "assemble" may be called from several threads at the same time, every call works on a context of its own.
+ */
+
+#include <stddef.h>
+
+
+/* this struct defines an entry label (same as a line of the .ent file) */
+typedef struct {
+	char *name;
+	int address;
+} asm_entry;
+
+/* this struct defines a use of an external label (same as a line of the .ext file) */
+typedef struct {
+	char *name;
+	int address; /* address of the word that calls the label */
+} asm_extern;
+
+/* this struct defines the result of assembling a source text */
+typedef struct {
+	unsigned short *words; /* the memory image from address 100: IC instruction words and then DC data words, 15 bits each */
+	int IC; /* num of instruction words */
+	int DC; /* num of data words */
+	asm_entry *entries; /* in the order they were defined */
+	int num_of_entries;
+	asm_extern *externs; /* sorted by address */
+	int num_of_externs;
+	char *diagnostics; /* all the messages, the same text "runfile" prints (never NULL) */
+} asm_result;
+
+
+/*
+ * assemble - Assembles a source text in memory.
+ * @src: The source text (as in a .as file), it doesn't have to be null-terminated.
+ * @len: The num of characters in the source text.
+ * @result: The result to be filled, it must be freed by "freeAsmResult" (whatever the return value is).
+ *
+ * Return: 0 - regular error (the messages are in the diagnostics)
+ *         1 - success
+ *         2 - memory error
+ */
+int assemble(const char *src, size_t len, asm_result *result);
+
+/* same as "assemble", with the name of the source used in the diagnostics */
+int assembleNamed(const char *name, const char *src, size_t len, asm_result *result);
+
+/* frees everything in a result that was filled by "assemble" */
+void freeAsmResult(asm_result *result);
+
+
+/*
+ * An incremental session, for an editor that assembles its buffer after every edit
+ * The session keeps the source and the results of assembling it. "sessionEdit" replaces a range of lines
+ * and returns the same result as "assemble" of the whole new source, but only the edited lines are
+ * tokenized again: the words and the labels after them are just moved, and the labels are resolved again.
+ * A source with macros (or ".include") is assembled as a whole on every edit, and so is a source that surpasses
+ * the memory limit or defines a label twice (in lines that are far apart).
+ * A session must not be used by two threads at the same time.
+ */
+typedef struct asm_session asm_session;
+
+/* creates an empty session, the name is used in the diagnostics (NULL on memory error) */
+asm_session *newSession(const char *name);
+
+/* assembles a new source in the session, the return value and the result are the same as "assemble" */
+int sessionAssemble(asm_session *session, const char *src, size_t len, asm_result *result);
+
+/*
+ * sessionEdit - Replaces "num_of_lines" lines from "first_line" (the first line is 1) by the lines of "text",
+ * and assembles the new source. "num_of_lines" may be 0 (an insert), and "text" may be empty (a delete).
+ * Return: same as "assemble", 0 also if the lines are out of the source.
+ */
+int sessionEdit(asm_session *session, int first_line, int num_of_lines, const char *text, size_t len, asm_result *result);
+
+/* frees a session */
+void freeSession(asm_session *session);
+
+
+/*
+ * The binary object file ("runfile --format=bin" writes "output/<name>.bin")
+ * The same memory image, entry labels and external uses as the .ob, .ent and .ext files, in a
+ * single file that can be mapped and used as is. All the fields are little-endian, every section
+ * starts at a multiple of 4 bytes.
+ *
+ *   offset 0   header (ASM_BIN_HEADER_SIZE bytes), 8 unsigned 32-bit fields:
+ *              magic ("AS15"), version, IC, DC, first address (100),
+ *              num of entries, num of externs, offset of the symbols section
+ *   offset 32  the words: IC instruction words and then DC data words, unsigned 16-bit each (15 bits used),
+ *              the i'th word is the word at address "first address + i"
+ *   symbols    the entries (in the order they were defined) and then the externs (sorted by address),
+ *              ASM_BIN_SYMBOL_SIZE bytes each: the name, null-padded to ASM_BIN_NAME_SIZE bytes,
+ *              and its unsigned 32-bit address
+ */
+#define ASM_BIN_MAGIC "AS15"
+#define ASM_BIN_VERSION 1
+#define ASM_BIN_HEADER_SIZE 32
+#define ASM_BIN_NAME_SIZE 32 /* a label name is at most 31 characters */
+#define ASM_BIN_SYMBOL_SIZE (ASM_BIN_NAME_SIZE + 4)
@@ -7,7 +7,9 @@
  *
  * Sections:
  * - Label Table: Defines structures and functions for label management.
+ * - Line IR: Defines the tokenized form of a source line.
  * - Memory Image: Defines structures and functions for the computer general memory management.
+ * - Assembler Context: Gathers all the state of the file being assembled.
  * - Declarations: Provides function declarations for various assembler operations.
  *
  */
@@ -24,16 +26,121 @@
    -----------------  */
 
 
+#define LABEL_TABLE_INIT_SIZE 256 /* initial num of label records */
+
+/* the kinds of labels */
+#define LABEL_CODE 0 /* ".code" - an instruction label */
+#define LABEL_DATA 1 /* ".data" */
+#define LABEL_STRING 2 /* ".string" */
+#define LABEL_EXTERNAL 3 /* ".external" */
+
+/* the flags of a label */
+#define LABEL_ENTRY 1 /* the label is also exported (".entry") */
+
 typedef struct Lnode *Lptr;
-/* struct of a label node */
+/* struct of a label record, the records of a file are packed in a single array, in definition order.
+ * NOTICE: a pointer to a record is valid until the next label is added (the array may be moved) */
 typedef struct Lnode {
-	char *label_name;
+	int name_id; /* id of the interned name in the symbol table */
 	int value;
-	char *type;
-	struct Lnode *next;
+	int line_num; /* the line the label is defined in */
+	unsigned char kind; /* LABEL_CODE, LABEL_DATA, LABEL_STRING or LABEL_EXTERNAL */
+	unsigned char flags; /* LABEL_ENTRY */
 } l_item;
-/* Global head pointer for the label linked list */
-struct Lnode *Labelhptr;
+
+/* struct of an interned name in the symbol table */
+typedef struct Sname {
+	char *name;
+	unsigned int hash;
+	int label; /* index of the label defined with this name, -1 if not defined */
+} s_name;
+
+unsigned int hashName(const char*);
+int internName(const char*);
+int findNameId(const char*);
+char *getName(int);
+Lptr findLabel(const char*);
+Lptr getLabelById(int);
+Lptr newLabel(int);
+void freeSymbolTable();
+
+
+/*  -----------------
+   |   (LINE IR)    |
+   -----------------  */
+
+
+#define MAX_LINE_WORDS (LINE_SIZE / 2 + 1) /* max num of words in a line */
+#define MAX_OPERANDS 2 /* max num of operands of an instruction */
+
+/* kinds of source lines */
+#define LINE_BLANK 0
+#define LINE_COMMENT 1
+#define LINE_INSTRUCTION 2
+#define LINE_DATA 3
+#define LINE_STRING 4
+#define LINE_ENTRY 5
+#define LINE_EXTERN 6
+
+/* addressing modes of operands */
+#define ADDR_IMMEDIATE 0
+#define ADDR_DIRECT 1
+#define ADDR_INDIRECT 2
+#define ADDR_REGISTER 3
+
+/* this struct defines a tokenized source line, the line is scanned once and all the stages work on the record */
+typedef struct {
+	int kind; /* LINE_BLANK, LINE_COMMENT, LINE_INSTRUCTION, LINE_DATA, ... */
+	int has_label; /* 1 if the first word ends with ':' */
+	char *words[MAX_LINE_WORDS]; /* whitespace separated words, when has_label the first one is the label name without ':' */
+	int num_of_words;
+	char *keyword; /* the instruction or directive word (the word after the label) */
+	char *args; /* the text after the keyword */
+	int opcode; /* opcode of the instruction, -1 if the keyword isn't an instruction */
+	char *operands[MAX_OPERANDS]; /* comma separated operands of the instruction */
+	int addressing[MAX_OPERANDS]; /* addressing mode of every operand by its spelling */
+	int num_of_operands;
+	int commas_ok; /* 0 if the operands aren't separated by single commas */
+	int length; /* num of machine words the instruction takes (L) */
+	char text[2 * LINE_SIZE + 2]; /* storage of the words and of the args */
+	char operand_text[LINE_SIZE + 2]; /* storage of the operands */
+} line_ir;
+
+void tokenizeLine(const char*, int, line_ir*);
+
+/* --(Character Classes)-- */
+
+#define CLASS_SPACE 1
+#define CLASS_COMMA 2
+#define SPACE_BITS_WORDS ((LINE_SIZE + 31) / 32) /* num of words in the whitespace bit set of a line */
+
+extern const unsigned char CHAR_CLASS[256];
+
+#define IS_SPACE(c) (CHAR_CLASS[(unsigned char) (c)] & CLASS_SPACE)
+#define IS_SEPARATOR(c) (CHAR_CLASS[(unsigned char) (c)] & (CLASS_SPACE | CLASS_COMMA)) /* a whitespace or a comma */
+
+void scanSpaces(const char*, int, unsigned int*);
+int findBit(const unsigned int*, int, int, int);
+
+
+/*  -----------------
+   |   (OPCODES)    |
+   -----------------  */
+
+#define NUM_OF_OPCODES 16
+#define ADDR_MASK(mode) (1 << (mode)) /* an addressing mode in the masks of the opcode table */
+
+/* this struct defines an instruction in the opcode table */
+typedef struct {
+	const char *name;
+	int operand_num;
+	int source_modes; /* mask of the addressing modes the source operand may use */
+	int target_modes; /* mask of the addressing modes the target operand may use */
+} opcode_info;
+
+extern const opcode_info OPCODES[NUM_OF_OPCODES]; /* indexed by the opcode */
+
+int findOpcode(const char*);
 
 
 /*  -----------------
@@ -41,30 +148,44 @@ struct Lnode *Labelhptr;
    -----------------  */
 
 
-#define MEMORY_SIZE 4096
+#define MEMORY_SIZE 4096 /* the default num of words in memory ("--mem-words") */
+#define MAX_MEMORY_WORDS (1 << 24)
+#define FIRST_ADDRESS 100 /* the address the program is loaded at */
+#define MAX_LABEL_ADDRESS 4095 /* the address of a label operand is encoded in 12 bits */
+#define MEMORY_PAGE_SHIFT 8
+#define MEMORY_PAGE_WORDS (1 << MEMORY_PAGE_SHIFT) /* num of words in a page of the memory image */
+
+extern int MEMORY_WORDS; /* the num of words in memory */
 
 /* this struct defines a cell of 16-bits in memory */
 typedef struct {
 	unsigned short MILA; /* last bit is ignored, only supports positive */
 } mila;
 
-/* --(Entire Memory Image)-- */
+/* this struct defines the memory image - a table of pages, a page is allocated only when a word in it is loaded */
+typedef struct {
+	mila **pages; /* the page of every MEMORY_PAGE_WORDS words, NULL when it was never touched */
+	int num_of_pages; /* num of entries in the table */
+} memory_image;
 
-mila memory_image[MEMORY_SIZE]; 
+int storeWords(int, const mila*, int);
+unsigned short memoryWord(int);
+void freeMemoryImage(memory_image*);
 
 /* --(Data Memory Image)-- */
 
-typedef struct dataNode *Dptr; /* declare pointer */
-/* this struct defines a cell in the data image */
-typedef struct dataNode {
-	mila cell;
-	int address; 
-	struct dataNode *next;
-} d_item;
-struct dataNode *Data_hptr; /* head pointer */
-
-int encodeData(char*, int, char*, int);
-int addExtern(char*, char*, int, int);
+#define DATA_IMAGE_INIT_SIZE 256 /* initial num of cells in the data image */
+
+/* this struct defines the data image - a growable buffer of cells written at DC */
+typedef struct {
+	mila *cells;
+	int size; /* num of cells in the image (DC) */
+	int capacity; /* num of allocated cells */
+} data_image;
+
+int encodeData(char*, int, int);
+int addExtern(line_ir*, char*, int, int);
+int setDataCell(int, mila);
 int addData(int, int);
 int addString(char, int);
 int loadLabelExtern(char*, char*, int); 
@@ -73,90 +194,495 @@ void freeDataImage();
 
 /* --(Instructions Memory Image)-- */
 
-typedef struct InstructionNode *Iptr; /* declare pointer */
-/* this struct defines a cell in the instruction image */
-typedef struct InstructionNode {
-	mila cell;
-	int address; 
-	struct InstructionNode *next;
-	struct InstructionNode *prev;
-} I_item;
-struct InstructionNode *Instruction_hptr; /* head pointer */
-
-
-/* this struct is used on an array when defining specifics about every instruction */
-typedef struct ins_length {
-    char *instruction; 
-    int operand_num;
-} ins_length;
-
-int encodeInstruction(char*, char*, int, int, int);
-int addInstruction(char*, int, char*, char*, int, int, int);
-int getAddressingType(char*, int, char*, char*);
+#define INSTRUCTION_IMAGE_INIT_SIZE 256 /* initial num of cells in the instruction image */
+
+/* this struct defines the instruction image - a flat buffer of cells indexed directly by IC,
+ * with a bitmap marking the cells that were already encoded (a clear bit means the cell still needs a fixup) */
+typedef struct {
+	mila *cells;
+	unsigned char *encoded; /* one bit for every cell */
+	int size; /* num of cells in the image (highest address + 1) */
+	int capacity; /* num of allocated cells */
+} instruction_image;
+
+
+int encodeInstruction(line_ir*, char*, int, int);
+int addInstruction(char*, int, line_ir*, int);
+int getAddressingType(char*, int, char*, int, char*);
 void printInstructionImage(); /* this function is used for test purposes only */
 void freeInstructionImage();
 
+/* --(Fixup Table)-- */
+
+#define FIXUP_TABLE_INIT_SIZE 64 /* initial num of records in the fixup table */
+
+/* kinds of fixup records */
+#define FIXUP_OPERAND 0 /* an operand word calling a label that wasn't known on the first stage */
+#define FIXUP_ENTRY 1 /* a ".entry" directive */
+#define FIXUP_ENTRY_EXCESS 2 /* a ".entry" directive followed by excess operands */
+
+/* this struct defines a record of work left for the second stage, records are kept in source order */
+typedef struct {
+	int address; /* IC of the operand word to be patched (FIXUP_OPERAND only) */
+	int name_id; /* id of the interned label name */
+	int line_num; /* source line in the .am file */
+	unsigned char kind;
+	unsigned char opcode; /* opcode of the instruction (FIXUP_OPERAND only) */
+	unsigned char operand; /* 0 - the only operand, 1 - first operand, 2 - second operand */
+} fixup;
+
+/* this struct defines the fixup table - a growable array of fixup records */
+typedef struct {
+	fixup *items;
+	int size; /* num of records in the table */
+	int capacity; /* num of allocated records */
+} fixup_table;
+
+int addFixup(int, int, char*, int, int, int);
+int addEntryFixup(line_ir*, int);
+void freeFixupTable();
+
+/* --(Extern Uses)-- */
+
+#define EXTERN_USES_INIT_SIZE 64 /* initial num of records in the extern uses list */
+
+/* this struct defines a use of an external label, recorded when the word is encoded */
+typedef struct {
+	int address; /* IC of the word that calls the label */
+	int name_id; /* id of the interned label name */
+} extern_use;
+
+/* this struct defines the extern uses list - a growable array of extern uses */
+typedef struct {
+	extern_use *items;
+	int size; /* num of uses in the list */
+	int capacity; /* num of allocated uses */
+} extern_uses;
+
+int addExternUse(int, int);
+void freeExternUses();
+
+#define OUTPUT_PLAN_INIT_SIZE 16 /* initial num of entries in the output plan */
+
+/* this struct defines the output plan - what the output files hold, gathered while the file is assembled */
+typedef struct {
+	int *entries; /* indices of the ".entry" labels, in the order of their definition once the plan is finished */
+	int num_of_entries;
+	int entries_capacity;
+	int num_of_externs; /* num of ".external" labels in the symbol table */
+} output_plan;
+
+/* this struct defines an output file that's written to a temporary file, and renamed once it's complete */
+typedef struct {
+	FILE *fp;
+	char *name; /* the name of the output file */
+	char *temp_name; /* "<name>.tmp" */
+} output_file;
+
+int planEntry(Lptr);
+Lptr plannedEntry(int);
+void finishOutputPlan();
+void freeOutputPlan();
+FILE *openOutput(output_file*, const char*, const char*);
+int closeOutput(output_file*);
+void discardOutput(output_file*);
+
+
+/*  -----------------------
+   | (ASSEMBLER CONTEXT) |
+   -----------------------  
+ ~(All the state of the file being assembled. Files are assembled in parallel, so every worker
+   thread works on a context of its own, reached through the thread's "Ctx" pointer)~ */
+
+#define TEXT_BUFFER_INIT_SIZE 4096 /* initial num of characters in a text buffer */
+
+/* this struct defines a growable null-terminated text */
+typedef struct {
+	char *text;
+	int size; /* num of characters in use */
+	int capacity; /* num of characters allocated */
+} text_buffer;
+
+/* this struct defines the symbol table - the interned names and their hash buckets */
+typedef struct {
+	s_name *names; /* interned names, indexed by their id */
+	int names_count;
+	int names_capacity;
+	int *buckets; /* (id + 1) of the name in every bucket, 0 when empty */
+	int buckets_size;
+	l_item *labels; /* the label records, in definition order */
+	int labels_count;
+	int labels_capacity;
+} symbol_table;
+
+/* this struct defines the macro table - the macro list and its hash buckets */
+typedef struct macro_table {
+	struct node *list; /* head of the macro list (kept in definition order) */
+	struct node *tail;
+	struct node **buckets; /* the macro node of every bucket, NULL when empty */
+	int buckets_size;
+	int count;
+	struct macro_table **libraries; /* the macro tables of the libraries included by the file (".include"), read-only */
+	int num_of_libraries;
+} macro_table;
+
+/*  ----------------
+   | (STATISTICS) |
+   ----------------  
+ ~(Timing and counters of the file being assembled, printed with "--stats")~ */
+
+/* the timed stages of the assembler */
+#define STAGE_PRE_ASSEMBLER 0
+#define STAGE_FIRST 1
+#define STAGE_SECOND 2
+#define STAGE_OUTPUT 3 /* createOutput, including loadPCMemory */
+#define STAGE_LOAD 4 /* loadPCMemory only */
+#define NUM_OF_STAGES 5
+
+/* this struct defines the statistics of a single file */
+typedef struct {
+	double stage_time[NUM_OF_STAGES]; /* wall time of every stage, in seconds */
+	double stage_start[NUM_OF_STAGES]; /* the time the running stages began */
+	long lines; /* num of source lines */
+	long label_lookups; /* finding or interning a label name */
+	long macro_lookups;
+	long list_walks; /* passes over the whole label table */
+	long allocations; /* allocations of the tables and buffers */
+} asm_stats;
+
+/* the instrumentation is built in only with "make STATS=1" (ASM_STATS), otherwise it compiles to nothing */
+#ifdef ASM_STATS
+#define STAT_COUNT(counter) (Ctx -> stats.counter++)
+#define STAT_BEGIN(stage) (Ctx -> stats.stage_start[stage] = statsClock())
+#define STAT_END(stage) (Ctx -> stats.stage_time[stage] += statsClock() - Ctx -> stats.stage_start[stage])
+#else
+#define STAT_COUNT(counter)
+#define STAT_BEGIN(stage)
+#define STAT_END(stage)
+#endif
+
+/* the formats of the statistics */
+#define STATS_OFF 0
+#define STATS_TEXT 1
+#define STATS_JSON 2
+
+extern int STATS_FORMAT;
+
+double statsClock();
+void printFileStats(char*, asm_stats*);
+void printStatsSummary(double);
+
+
+/*  -----------------
+   | (DIAGNOSTICS) |
+   -----------------  
+ ~(Every diagnostic of the file being assembled, with its code, line and severity, printed once the file is done)~ */
+
+/* the codes of the diagnostics, the severity of a diagnostic is told by its code */
+#define DIAG_NONE 0 /* a progress message */
+
+/* source and pre-assembler */
+#define DIAG_FILE_UNREADABLE 101
+#define DIAG_FILE_NAME 102
+#define DIAG_LINE_TOO_LONG 103
+#define DIAG_MACRO_CALL 104
+#define DIAG_MACRO_DEFINITION 105
+#define DIAG_MACRO_NAME 106
+#define DIAG_MACRO_REDEFINED 107
+#define DIAG_MACRO_IN_LINE 108
+#define DIAG_INCLUDE 109
+#define DIAG_LIBRARY_CONTENT 110
+
+/* labels */
+#define DIAG_LABEL_INVALID 201
+#define DIAG_LABEL_REDEFINED 202
+#define DIAG_LABEL_MACRO 203
+#define DIAG_LABEL_UNKNOWN 204
+#define DIAG_LABEL_ADDRESS 205
+
+/* instructions and operands */
+#define DIAG_UNKNOWN_INSTRUCTION 301
+#define DIAG_COMMAS 302
+#define DIAG_OPERAND 303
+#define DIAG_REGISTER 304
+#define DIAG_ADDRESSING 305
+
+/* directives */
+#define DIAG_DATA 401
+#define DIAG_ENTRY_EXTERN 402
+
+/* memory image and output files */
+#define DIAG_MEMORY_LIMIT 501
+#define DIAG_OUTPUT_FILE 502
+
+/* linker */
+#define DIAG_LINK_NAME 601
+#define DIAG_LINK_ENTRY 602
+#define DIAG_LINK_UNRESOLVED 603
+#define DIAG_LINK_FILES 604 /* not all the files were assembled */
+
+/* the summary of a file, or of the link, that has errors */
+#define DIAG_FILE_FAILED 701
+
+/* notices (800-899) */
+#define DIAG_LABEL_IGNORED 801
+#define DIAG_ERRORS_LIMIT 802
+
+/* fatal errors (900-999), the program exits */
+#define DIAG_NO_MEMORY 901
+
+#define SEVERITY_INFO 0
+#define SEVERITY_ERROR 1
+#define SEVERITY_NOTICE 2
+#define SEVERITY_FATAL 3
+#define DIAG_SEVERITY(code) ((code) >= 900 ? SEVERITY_FATAL : (code) >= 800 ? SEVERITY_NOTICE : (code) > 0 ? SEVERITY_ERROR : SEVERITY_INFO)
+
+/* this struct defines a diagnostic, its text is kept in the log of the context */
+typedef struct {
+	int code; /* DIAG_... */
+	int line; /* the source line, 0 when it isn't about a single line */
+	const char *file; /* the file (or the macro library) it's about, NULL when unknown */
+	int offset; /* the text of the diagnostic in the log */
+	int length;
+} diagnostic;
+
+/* this struct defines the diagnostics of a file, in the order they were found */
+typedef struct {
+	diagnostic *items;
+	int count;
+	int capacity;
+} diagnostic_list;
+
+#define DIAGNOSTICS_INIT_SIZE 64 /* initial num of diagnostics */
+
+/* the formats of the diagnostics ("--diagnostics=") */
+#define DIAG_TEXT 0 /* the messages as they are (default) */
+#define DIAG_JSON 1 /* a JSON object per diagnostic, one per line */
+#define JSON_ESCAPE_SIZE 6 /* max num of characters of a character in a JSON string ("\u001f") */
+
+extern int DIAG_FORMAT;
+extern int MAX_ERRORS; /* a file is stopped after this num of errors ("--max-errors"), 0 - no limit */
+extern int DIAG_STDERR; /* 1 - the diagnostics are printed to stderr, stdout carries the output stream ("-") */
+
+
+/*  -----------
+   | (ARENA) |
+   -----------  
+ ~(The nodes and strings of the file being assembled, freed all at once between files)~ */
+
+#define ARENA_BLOCK_SIZE 65536 /* num of bytes in a block of the arena */
+
+/* this struct defines a block of the arena, its data comes right after it */
+typedef struct arena_block {
+	struct arena_block *next;
+	size_t size; /* num of bytes that can be allocated from the block */
+	size_t used; /* num of bytes already allocated */
+} arena_block;
+
+/* this struct defines the arena - a list of blocks, allocations are taken from the current one */
+typedef struct {
+	arena_block *first;
+	arena_block *current;
+} arena;
+
+void *arenaAlloc(arena*, size_t);
+char *arenaCopy(arena*, const char*);
+void resetArena(arena*);
+void freeArena(arena*);
+
+
+/*  -----------------------
+   | (DEBUG ALLOCATIONS) |
+   -----------------------  
+ ~(Counting the heap allocations of the file being assembled, built in only with "make DEBUG_ALLOC=1")~ */
+
+/* with ASM_DEBUG_ALLOC every malloc, calloc and realloc is counted in the context, and the first stage asserts
+   that a line that was assembled successfully made no heap allocation but the amortized growth of a table
+   or of the arena (marked by TABLE_GROWTH) */
+#ifdef ASM_DEBUG_ALLOC
+#include <assert.h>
+void *debugMalloc(size_t);
+void *debugCalloc(size_t, size_t);
+void *debugRealloc(void*, size_t);
+#define malloc(size) debugMalloc(size)
+#define calloc(count, size) debugCalloc(count, size)
+#define realloc(p, size) debugRealloc(p, size)
+#define TABLE_GROWTH() do { STAT_COUNT(allocations); Ctx -> table_growths++; } while (0)
+#define LINE_ALLOCATIONS_BEGIN (Ctx -> line_allocations = Ctx -> heap_allocations - Ctx -> table_growths)
+#define ASSERT_NO_LINE_ALLOCATIONS assert(Ctx -> heap_allocations - Ctx -> table_growths == Ctx -> line_allocations)
+#else
+#define TABLE_GROWTH() STAT_COUNT(allocations)
+#define LINE_ALLOCATIONS_BEGIN
+#define ASSERT_NO_LINE_ALLOCATIONS
+#endif
+
+
+typedef struct {
+	arena arena; /* owns the interned names and the macros */
+	symbol_table symbols;
+	macro_table macros;
+	text_buffer am_buffer; /* the macro-expanded source, shared by the pre-assembler and the first stage */
+	instruction_image instruction_image; /* the instruction image, indexed by IC */
+	data_image data_image; /* the data image, indexed by DC */
+	fixup_table fixup_table; /* work left for the second stage, in source order */
+	extern_uses extern_uses; /* every use of an external label */
+	output_plan output_plan; /* the entries and the externs of the output files */
+	memory_image memory_image; /* the memory image, its pages are kept for the next files of the context */
+	text_buffer log; /* the text of the diagnostics of the file, when they're buffered */
+	diagnostic_list diagnostics; /* the diagnostics in the log */
+	int buffer_log; /* 1 - the diagnostics are kept in "log" until the file is done, 0 - printed at once */
+	const char *file_name; /* the file being assembled, the file of its diagnostics */
+	int error_count; /* num of errors of the file */
+	int errors_capped; /* 1 - the file was stopped by "--max-errors", and it was reported */
+	int stage_chunk; /* 1 - a chunk of the first stage: its label operands are left to the fixup table, the memory limit is checked on merge */
+	asm_stats stats; /* the statistics of the file ("--stats") */
+	long heap_allocations; /* every heap allocation (ASM_DEBUG_ALLOC) */
+	long table_growths; /* the allocations that grow a table or the arena (ASM_DEBUG_ALLOC) */
+	long line_allocations; /* the heap allocations before the current line (ASM_DEBUG_ALLOC) */
+} asm_context;
+
+extern __thread asm_context *Ctx; /* the context of the current thread */
+
+asm_context *newContext(int);
+void freeContext(asm_context*);
+int appendText(text_buffer*, const char*, int);
+int escapeJson(char, char*);
+void logPrintf(const char*, ...);
+void diagPrintf(int, int, const char*, ...);
+void appendLog(asm_context*);
+int renderLog(asm_context*, text_buffer*);
+void flushLog(asm_context*);
+int tooManyErrors(char*);
+
+
+/* the formats of the output files */
+#define FORMAT_TEXT 0 /* the .ob, .ent and .ext files (default) */
+#define FORMAT_BIN 1 /* a single binary object file, .bin */
+
+extern int OUTPUT_FORMAT;
+extern int OUTPUT_FILES; /* 0 - the output files of the files aren't written, only their linked image ("--link-only") */
+extern int OUTPUT_STREAM; /* 1 - the output files are written to stdout as a single stream, instead of "output/" ("-") */
+
+/* the lines that start the sections of the text output stream, a label never starts with '.' */
+#define STREAM_OBJECT ".ob\n"
+#define STREAM_ENTRIES ".ent\n"
+#define STREAM_EXTERNS ".ext\n"
+#define STREAM_END ".end\n"
+
+
+/* the build cache ("--cache"), see build_cache.c */
+#define ASSEMBLER_VERSION "1.0" /* part of the cache key, must be changed whenever the output files may change */
+#define CACHE_KEY_SIZE 24 /* num of characters in a cache key */
+
+extern int USE_CACHE;
+
+int cacheKey(FILE*, char*);
+int replayCache(const char*, char*);
+void storeCache(const char*, char*);
+
+
+/* the in-memory linker ("--link"), see linker.c */
+
+/* this struct defines a symbol of a module, an entry or a use of an external label */
+typedef struct {
+	int name; /* offset of the label name in the names of the module */
+	int address; /* the address of an entry, or the IC of the word that uses an extern */
+} link_symbol;
+
+/* this struct defines a module - the output of a file that was assembled, kept for the linker */
+typedef struct {
+	char *file_name;
+	int kept; /* 1 - the file was assembled successfully and kept */
+	int IC; /* num of instruction words */
+	int DC; /* num of data words */
+	unsigned short *words; /* the instruction words, and then the data words */
+	link_symbol *entries;
+	int num_of_entries;
+	link_symbol *externs;
+	int num_of_externs;
+	text_buffer names; /* the null-terminated names of the symbols */
+	int code_address; /* the address of the instructions in the linked image */
+	int data_address; /* the address of the data in the linked image */
+} link_module;
+
+int keepModule(link_module*, char*);
+void freeModule(link_module*);
+int linkModules(link_module*, int, const char*);
+
 
 /*  -----------------
    | (DECLERATIONS) |
    -----------------  */
 
 
+/* the first stage of a large source is split into chunks ("--stage-threads"), see first_stage_chunks.c */
+#define STAGE_CHUNK_MIN_SIZE 65536 /* the minimal num of characters in a chunk */
+
+extern int STAGE_THREADS; /* the num of threads of the first stage of a file */
+
+/* this struct defines a chunk of the expanded source (also a segment of an incremental session, see assemble.c) */
+typedef struct {
+	asm_context *ctx; /* the context of the chunk, the context of the file for the first chunk */
+	char *file_name;
+	int start; /* position of the first line of the chunk */
+	int end; /* position right after its last line */
+	int line_num; /* num of lines before the chunk */
+	int line_offset; /* added to the line numbers of its labels and fixups on merge (a segment that moved) */
+	int IC; /* num of instruction words of the chunk */
+	int DC; /* num of data words of the chunk */
+	int result; /* the result of "first_stage_lines" */
+} stage_chunk;
+
 int first_stage(char*);
+int first_stage_lines(char*, int, int, int, int*, int*);
+int first_stage_chunks(char*);
+void *runChunk(void*);
+asm_context *newChunkContext(asm_context*);
+void freeChunkContext(asm_context*);
+int mergeChunk(stage_chunk*, int, int);
 int second_stage(char*);
 
-int clearOfMacro(char*, char*, int);
-char *findDataOrStringWord(char*, char*, int);
-char *findEntryOrExternWord(char*, char*, int);
-int isLabel(char*, char*, int);
+int clearOfMacro(line_ir*, char*, int);
+int checkEntryOrExtern(line_ir*, char*, int);
+int isLabel(line_ir*, char*, int);
 int isAlreadyLabel(char*);
-char *getLabelStatus(char*);
+int getLabelStatus(char*);
 int getLabelAddress(char*);
-int validInstructionName(char*);
-int validInstructionAddress(char*, int);
-int valid2operandsAddress(char*, int, int);
-int validOperandAddress(char*, int , char*);
-int replaceCommas(char*);
-int addLabel(char*, int, char*, char*, int);
+int validInstructionAddress(int, int);
+int valid2operandsAddress(int, int, int);
+int validOperandAddress(int, int);
+int addLabel(char*, int, int, char*, int);
 void printLabel(); /* this function is used for test purposes only */
 void updateLabels(int);
 void freeLabel();
-char *addSpacesAfterCommas(char*);
-char *replaceCommasWithSpaces(char*);
-
-int addEntry(char*, int, char*);
-int changeEntryStatus(char*, int, char*);
-char *get_third_word(char*);
-char *get_fourth_word(char*);
-int encodeMissingOperand(char*, int, char*, int, int);
-int encodeLabelMila(char*, int);
-int findNumOfWords(char*);
-int LabelWasAlreadyEncoded(int);
+
+int addEntry(char*, int, Lptr);
+int changeEntryStatus(char*, int, Lptr);
+int encodeLabelMila(Lptr, int);
+int encodeFixup(char*, fixup*);
 int loadPCMemory();
-int createOutput(char*, int, FILE*);
+int createOutput(char*);
 int countInstructionCell();
 int countDataCell();
 int entryLabelsExists();
 int externLabelExists();
-int write2Extern(char*, int, FILE*, FILE*);
-int isExternLabel(char*);
-int isDataORstring(char*, char*);
-int isExternORentry(char*, char*);
-int checkRegisters(char*, char*, char*);
-int isRegister( char*);
-void print2ExternFile(char*, char*, char*, char*, int, FILE*);
-int check4OperandEntry(char*, int, char*, int);
+int write2Object(FILE*);
+int write2Ent(FILE*);
+int write2Extern(FILE*);
+int write2Binary(FILE*);
+void putWord32(unsigned char*, unsigned long);
+void putSymbol(unsigned char*, const char*, int);
+int formatDecimal(char*, int, int);
+void formatOctalWord(char*, unsigned int);
+int writeLabelLine(text_buffer*, const char*, int, int);
 
 /* excess functions */
-void insertDataToNode(Iptr, mila, int);
-void assignNodeToList(Iptr);
-char *skipFirstWord(char*);
-int checkERRloadLabelADRRtype(int, mila, int, Iptr);
-int checkValidOperands(int, int, char*, int, int);
-int encodeMila(char*, int, int, char*, char*, int, char*);
-int encodeRegisterMilaOnly(char*, int, char*, int);
-int isAddressType2Or3(char*, char*, int);
-char *skip_word(char*);
+int setInstructionCell(int, mila);
+int isInstructionCellEncoded(int);
+int checkERRloadLabelADRRtype(int, mila, int);
+int checkValidOperands(int, int, int, int, int);
+int encodeMila(char*, int, int, char*, int, char*);
+int encodeRegisterMilaOnly(char*, int, char*, char*, int);
 void printPCmemory(); /* this function is used for test purposes only */
 
 
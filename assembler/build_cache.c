@@ -0,0 +1,247 @@
+/*
+ * build_cache.c - This file contains the build cache of the assembler ("--cache").
+ * The output files of every file that was assembled successfully are kept under the cache/ directory,
+ * named by a key made of the hash of the source text, the assembler version and the options that change
+ * the output files (the memory size and the output format). When a file with the same key is assembled again, its output files are copied from the cache instead of running the
+ * pre-assembler and the two stages of the assembler.
+ * A file with errors is never cached, so its diagnostics are printed on every run.
+ */
+
+#define _XOPEN_SOURCE 600 /* mkdir */
+#include <sys/stat.h>
+#include "assembler.h"
+#include "../pre_processing/pre_assembler.h"
+
+
+#define CACHE_DIR "cache"
+#define CACHED_NAME_SIZE (sizeof(CACHE_DIR) + CACHE_KEY_SIZE + 8) /* "cache/<key><extension>" */
+#define OUTPUT_NAME_SIZE (256 + 12) /* "output/<file name><extension>", a file name is less than 256 characters */
+#define OPTIONS_TEXT_SIZE (sizeof(ASSEMBLER_VERSION) + 48) /* "<version> mem-words=<num> format=<num>" */
+
+int USE_CACHE = 0;
+
+
+/*
+ * cachedExtensions - Returns the extensions of the output files in the current output format.
+ *
+ * Return: A NULL-terminated array of extensions, the first one is the file that is always created.
+ */
+static const char **cachedExtensions()
+{
+	static const char *text_extensions[] = {".ob", ".ent", ".ext", NULL};
+	static const char *bin_extensions[] = {".bin", NULL};
+
+	return (OUTPUT_FORMAT == FORMAT_BIN) ? bin_extensions : text_extensions;
+}
+
+
+/*
+ * copyFile - Copies a whole file.
+ * @from: Name of the file to be copied.
+ * @to: Name of the new file, it's replaced only once the copy is complete.
+ *
+ * Return: 1 on success, 0 if the file couldn't be read or written.
+ */
+static int copyFile(const char *from, const char *to)
+{
+	FILE *in = fopen(from, "rb");
+	output_file out;
+	source_text src;
+
+	if (in == NULL) {
+		return 0;
+	}
+	if (readSource(in, &src) != 1) {
+		fclose(in);
+		free(src.text);
+		return 0;
+	}
+	fclose(in);
+
+	if (openOutput(&out, to, "wb") == NULL) {
+		freeSource(&src);
+		return 0;
+	}
+	if (fwrite(src.text, 1, src.size, out.fp) != (size_t) src.size) {
+		discardOutput(&out);
+		freeSource(&src);
+		return 0;
+	}
+	freeSource(&src);
+	return closeOutput(&out);
+}
+
+
+/*
+ * hashText - Adds a text to the two hashes of a cache key.
+ * @text: The text, it doesn't have to be null-terminated.
+ * @size: The num of characters in the text.
+ * @fnv: The FNV-1a hash.
+ * @djb: The djb2 hash.
+ */
+static void hashText(const char *text, int size, unsigned int *fnv, unsigned int *djb)
+{
+	int i;
+
+	for (i = 0; i < size; i++) {
+		*fnv = (*fnv ^ (unsigned char) text[i]) * 16777619u;
+		*djb = (*djb * 33) ^ (unsigned char) text[i];
+	}
+}
+
+
+/*
+ * hashLibraries - Adds the macro libraries included by a source text to the two hashes of a cache key.
+ * @src: The source text.
+ * @fnv: The FNV-1a hash.
+ * @djb: The djb2 hash.
+ *
+ * The name and the text of every library of an '.include' line are hashed, a library that can't be
+ * read is skipped (the file has errors then, it's never cached).
+ *
+ * Return: 1 on success, 2 on memory error.
+ */
+static int hashLibraries(const source_text *src, unsigned int *fnv, unsigned int *djb)
+{
+	char library_name[LIBRARY_NAME_SIZE + 1];
+	int pos = 0;
+
+	while (nextInclude(src, &pos, library_name))
+	{
+		source_text library;
+		FILE *fp;
+		int read_err;
+
+		if ((fp = fopen(library_name, "r")) == NULL) {
+			continue;
+		}
+
+		read_err = readSource(fp, &library);
+		fclose(fp);
+		if (read_err == 2) {
+			return 2;
+		}
+		if (read_err == 1) {
+			hashText(library_name, strlen(library_name) + 1, fnv, djb);
+			hashText(library.text, library.size, fnv, djb);
+			freeSource(&library);
+		}
+	}
+	return 1;
+}
+
+
+/*
+ * cacheKey - Calculates the cache key of a source file.
+ * @fp: File pointer to the source file, it's rewound to the start of the file.
+ * @key: The key to be filled, CACHE_KEY_SIZE characters.
+ *
+ * The key is made of two 32-bit hashes (FNV-1a and djb2) of the assembler version and the options
+ * that change the output of a successful file ("--mem-words" and the output format), followed by the
+ * source text and the macro libraries it includes, and the size of the text.
+ *
+ * Return: 1 on success, 0 on read error, 2 on memory error.
+ */
+int cacheKey(FILE *fp, char *key)
+{
+	char options[OPTIONS_TEXT_SIZE];
+	unsigned int fnv = 2166136261u;
+	unsigned int djb = 5381;
+	source_text src;
+	int read_err;
+
+	read_err = readSource(fp, &src);
+	rewind(fp);
+	if (read_err != 1) {
+		free(src.text);
+		return read_err;
+	}
+
+	/* a source with more words than the default memory succeeds only with a bigger "--mem-words" */
+	sprintf(options, "%s mem-words=%d format=%d", ASSEMBLER_VERSION, MEMORY_WORDS, OUTPUT_FORMAT);
+	hashText(options, strlen(options), &fnv, &djb);
+	hashText(src.text, src.size, &fnv, &djb);
+	if (hashLibraries(&src, &fnv, &djb) == 2) {
+		freeSource(&src);
+		return 2;
+	}
+
+	sprintf(key, "%08x%08x%08x", fnv, djb, (unsigned int) src.size);
+	freeSource(&src);
+	return 1;
+}
+
+
+/*
+ * replayCache - Copies the cached output files of a given key to the output directory.
+ * @key: The cache key of the source file.
+ * @file_name: The name of the file being processed.
+ *
+ * Return: 1 if the output files were found in the cache (a hit), 0 otherwise (a miss).
+ */
+int replayCache(const char *key, char *file_name)
+{
+	const char **extensions = cachedExtensions();
+	char cached_name[CACHED_NAME_SIZE];
+	char output_name[OUTPUT_NAME_SIZE];
+	struct stat st;
+	int i;
+
+	/* the first output file is always created, without it the key is not cached */
+	snprintf(cached_name, sizeof(cached_name), "%s/%s%s", CACHE_DIR, key, extensions[0]);
+	if (stat(cached_name, &st) != 0) {
+		return 0;
+	}
+
+	for (i = 0; extensions[i] != NULL; i++) {
+		snprintf(cached_name, sizeof(cached_name), "%s/%s%s", CACHE_DIR, key, extensions[i]);
+		snprintf(output_name, sizeof(output_name), "output/%s%s", file_name, extensions[i]);
+
+		if (stat(cached_name, &st) == 0 && copyFile(cached_name, output_name) == 0) {
+			return 0; /* assemble the file as usual */
+		}
+	}
+	return 1;
+}
+
+
+/*
+ * storeCache - Copies the output files that were just created to the cache.
+ * @key: The cache key of the source file.
+ * @file_name: The name of the file being processed.
+ *
+ * Every file is copied under a temporary name and then renamed, so a file that is assembled at
+ * the same time by another worker never sees a partial cache entry.
+ * The cache is only an optimization, a file that can't be cached is silently skipped.
+ * NOTICE: it must be called before the tables of the file are freed.
+ */
+void storeCache(const char *key, char *file_name)
+{
+	const char **extensions = cachedExtensions();
+	char cached_name[CACHED_NAME_SIZE];
+	char temp_name[CACHED_NAME_SIZE + 24];
+	char output_name[OUTPUT_NAME_SIZE];
+	int i;
+
+	mkdir(CACHE_DIR, 0777); /* may already exist */
+
+	/* the first output file marks a complete cache entry, so it's stored last */
+	for (i = 0; extensions[i] != NULL; i++) ;
+	while (i-- > 0) {
+
+		/* the .ent and .ext files are only created when needed (an older one may be left in the output directory) */
+		if ((strcmp(extensions[i], ".ent") == 0 && entryLabelsExists() == 0) ||
+			(strcmp(extensions[i], ".ext") == 0 && externLabelExists() == 0)) {
+			continue;
+		}
+
+		snprintf(cached_name, sizeof(cached_name), "%s/%s%s", CACHE_DIR, key, extensions[i]);
+		snprintf(temp_name, sizeof(temp_name), "%s.%lx.tmp", cached_name, (unsigned long) Ctx);
+		snprintf(output_name, sizeof(output_name), "output/%s%s", file_name, extensions[i]);
+
+		if (copyFile(output_name, temp_name) == 0 || rename(temp_name, cached_name) != 0) {
+			remove(temp_name);
+			return; /* the entry stays incomplete, and is never replayed */
+		}
+	}
+}
@@ -0,0 +1,85 @@
+/*
+ * char_class.c - This file contains the character classes of the tokenizer.
+ * Every character is classified once by a 256-entry table (whitespace, comma) instead of calling "isspace"
+ * for it again and again. A whole line is classified in a single pass into a bit set of its whitespaces,
+ * 16 characters at a time when SSE2 is available, and the tokenizer finds the boundaries of its words
+ * by scanning the bits.
+ */
+
+#include "assembler.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+
+/* the classes of the characters, the whitespaces are the ones of "isspace" (' ', '\t', '\n', '\v', '\f', '\r') */
+const unsigned char CHAR_CLASS[256] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 0, 0, /* 0-15 */
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 16-31 */
+	1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 0, 0, /* 32-47 */
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 48-63 */
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 64-79 */
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 80-95 */
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 96-111 */
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 /* 112-127, the rest are 0 */
+};
+
+
+/*
+ * scanSpaces - Classifies the characters of a line into a bit set of its whitespaces.
+ * @line: The line, it doesn't have to be null-terminated.
+ * @length: The num of characters in the line, at most LINE_SIZE.
+ * @bits: The bit set to be filled (SPACE_BITS_WORDS words), bit i is set when line[i] is a whitespace.
+ */
+void scanSpaces(const char *line, int length, unsigned int *bits)
+{
+	int i = 0;
+
+	memset(bits, 0, SPACE_BITS_WORDS * sizeof(unsigned int));
+
+#ifdef __SSE2__
+	/* 16 characters at a time, never reading past the end of the line */
+	for (; i + 16 <= length; i += 16) {
+		__m128i chunk = _mm_loadu_si128((const __m128i *) (line + i));
+		__m128i control = _mm_sub_epi8(chunk, _mm_set1_epi8('\t')); /* '\t'-'\r' become 0-4 */
+		__m128i spaces = _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')),
+			_mm_cmpeq_epi8(_mm_min_epu8(control, _mm_set1_epi8(4)), control));
+
+		bits[i >> 5] |= (unsigned int) _mm_movemask_epi8(spaces) << (i & 31);
+	}
+#endif
+
+	/* the rest of the line, a character at a time */
+	for (; i < length; i++) {
+		if (IS_SPACE(line[i])) {
+			bits[i >> 5] |= 1u << (i & 31);
+		}
+	}
+}
+
+
+/*
+ * findBit - Finds the next position of a bit set that has a given value.
+ * @bits: The bit set (made by "scanSpaces").
+ * @from: The position the search starts at.
+ * @length: The num of positions in the bit set.
+ * @value: 1 to find the next set bit (a whitespace), 0 to find the next clear bit.
+ *
+ * Return: The position, or length if there is none.
+ */
+int findBit(const unsigned int *bits, int from, int length, int value)
+{
+	int i = from;
+
+	while (i < length) {
+		unsigned int word = value ? bits[i >> 5] : ~bits[i >> 5];
+
+		word >>= (i & 31);
+		if (word != 0) {
+			i += __builtin_ctz(word);
+			return (i < length) ? i : length;
+		}
+		i = (i | 31) + 1; /* the next word */
+	}
+	return length;
+}
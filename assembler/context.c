@@ -0,0 +1,476 @@
+/*
+ * context.c - This file contains the assembler context.
+ * All the state of the file being assembled (label and macro tables, expanded source, memory images,
+ * fixup table, extern uses and the diagnostics) is kept in a single context, so that several files
+ * can be assembled at the same time, each by its own worker thread.
+ * Every thread reaches the context of the file it's working on through its "Ctx" pointer.
+ */
+
+#define _XOPEN_SOURCE 600 /* vsnprintf */
+#include <stdarg.h>
+#include <ctype.h>
+#include "assembler.h"
+
+
+__thread asm_context *Ctx = NULL;
+
+int DIAG_FORMAT = DIAG_TEXT;
+int MAX_ERRORS = 0;
+int DIAG_STDERR = 0;
+
+
+/*
+ * newContext - Creates an empty assembler context.
+ * @buffer_log: 1 - keep the diagnostics in the context until the file is done, 0 - print them at once.
+ *
+ * Return: The new context, NULL on memory error.
+ */
+asm_context *newContext(int buffer_log)
+{
+	asm_context *ctx = (asm_context *) calloc(1, sizeof(asm_context));
+	if (ctx == NULL) {
+		return NULL;
+	}
+	ctx -> buffer_log = buffer_log;
+	return ctx;
+}
+
+
+/*
+ * freeContext - Frees an assembler context and its diagnostics.
+ * @ctx: The context to be freed.
+ * NOTICE: the tables of the file are freed by the "MAIN_" cleanup macros once the file is done,
+ * the blocks of the arena are kept until the context itself is freed.
+ */
+void freeContext(asm_context *ctx)
+{
+	if (ctx == NULL) {
+		return;
+	}
+	freeArena(&ctx -> arena);
+	freeMemoryImage(&ctx -> memory_image);
+	free(ctx -> log.text);
+	free(ctx -> diagnostics.items);
+	free(ctx);
+}
+
+
+/*
+ * appendText - Appends text to the end of a text buffer.
+ * @buffer: The text buffer.
+ * @text: The text to be appended, it doesn't have to be null-terminated.
+ * @length: The num of characters in the text.
+ *
+ * The buffer is doubled whenever it's full, and is kept null-terminated.
+ *
+ * Return: 1 on success, 0 on memory error.
+ */
+int appendText(text_buffer *buffer, const char *text, int length)
+{
+	/* make room for the text and the null-terminator */
+	if (buffer -> size + length + 1 > buffer -> capacity) {
+		int new_capacity = (buffer -> capacity == 0) ? TEXT_BUFFER_INIT_SIZE : buffer -> capacity;
+		char *new_text;
+		while (buffer -> size + length + 1 > new_capacity) {
+			new_capacity *= 2;
+		}
+		new_text = (char *) realloc(buffer -> text, new_capacity);
+		TABLE_GROWTH();
+		if (new_text == NULL) {
+			return 0; /* memory error */
+		}
+		buffer -> text = new_text;
+		buffer -> capacity = new_capacity;
+	}
+
+	memcpy(buffer -> text + buffer -> size, text, length);
+	buffer -> size += length;
+	buffer -> text[buffer -> size] = '\0';
+	return 1;
+}
+
+
+/*
+ * escapeJson - Writes a character the way it's written in a JSON string.
+ * @c: The character.
+ * @out: The text to be filled, at least JSON_ESCAPE_SIZE characters (it's not null-terminated).
+ *
+ * Return: The num of characters written.
+ */
+int escapeJson(char c, char *out)
+{
+	unsigned char u = (unsigned char) c;
+
+	if (u == '"' || u == '\\') {
+		out[0] = '\\';
+		out[1] = c;
+		return 2;
+	}
+	if (u == '\n' || u == '\t') {
+		out[0] = '\\';
+		out[1] = (u == '\n') ? 'n' : 't';
+		return 2;
+	}
+	if (u < 0x20) {
+		char escape[8];
+		sprintf(escape, "\\u%04x", u);
+		memcpy(out, escape, 6);
+		return 6;
+	}
+	out[0] = c;
+	return 1;
+}
+
+
+/*
+ * appendEscaped - Appends a text to a text buffer as the contents of a JSON string.
+ * @out: The text buffer.
+ * @text: The text.
+ * @length: The num of characters in the text.
+ *
+ * Return: 1 on success, 0 on memory error.
+ */
+static int appendEscaped(text_buffer *out, const char *text, int length)
+{
+	char escape[JSON_ESCAPE_SIZE];
+	int ok = 1;
+	int i;
+
+	for (i = 0; ok && i < length; i++) {
+		ok = appendText(out, escape, escapeJson(text[i], escape));
+	}
+	return ok;
+}
+
+
+/*
+ * appendJson - Appends a diagnostic as a JSON object (a line of its own) to a text buffer.
+ * @out: The text buffer.
+ * @d: The diagnostic.
+ * @text: The text of the diagnostic.
+ *
+ * The message is the text without its leading and trailing white space, a diagnostic with no message
+ * (a blank line between the messages) isn't appended.
+ *
+ * Return: 1 on success, 0 on memory error.
+ */
+static int appendJson(text_buffer *out, const diagnostic *d, const char *text)
+{
+	static const char *severities[] = {"info", "error", "notice", "fatal"};
+	const char *start = text, *end = text + d -> length;
+	char field[64];
+	int ok;
+
+	while (start < end && isspace((unsigned char) *start)) {
+		start++;
+	}
+	while (end > start && isspace((unsigned char) end[-1])) {
+		end--;
+	}
+	if (start == end) {
+		return 1;
+	}
+
+	ok = appendText(out, "{\"file\":", 8);
+	if (d -> file == NULL) {
+		ok = ok && appendText(out, "null", 4);
+	} else {
+		ok = ok && appendText(out, "\"", 1) && appendEscaped(out, d -> file, strlen(d -> file)) && appendText(out, "\"", 1);
+	}
+	if (d -> line > 0) {
+		sprintf(field, ",\"line\":%d", d -> line);
+	} else {
+		strcpy(field, ",\"line\":null");
+	}
+	ok = ok && appendText(out, field, strlen(field));
+	sprintf(field, ",\"severity\":\"%s\",\"code\":%d,\"message\":\"", severities[DIAG_SEVERITY(d -> code)], d -> code);
+	ok = ok && appendText(out, field, strlen(field));
+
+	return ok && appendEscaped(out, start, end - start) && appendText(out, "\"}\n", 3);
+}
+
+
+/*
+ * printDiagnostic - Prints a single diagnostic at once, in the format of the diagnostics.
+ * @d: The diagnostic.
+ * @text: The text of the diagnostic.
+ */
+static void printDiagnostic(const diagnostic *d, const char *text)
+{
+	text_buffer json = {NULL, 0, 0};
+
+	if (DIAG_FORMAT == DIAG_TEXT) {
+		fwrite(text, 1, d -> length, DIAG_STDERR ? stderr : stdout);
+		return;
+	}
+	if (appendJson(&json, d, text) == 1 && json.size > 0) {
+		fwrite(json.text, 1, json.size, DIAG_STDERR ? stderr : stdout);
+	}
+	free(json.text);
+}
+
+
+/*
+ * storeDiagnostic - Keeps a diagnostic in the log of the current context.
+ * @d: The diagnostic, its offset is set here.
+ * @text: The text of the diagnostic.
+ *
+ * The errors of the context are counted, and a progress message right after another one is kept
+ * as a part of it. When the diagnostics of the context aren't buffered, the diagnostic is printed at once.
+ * NOTICE: when the log can't grow, the diagnostic is printed at once.
+ */
+static void storeDiagnostic(diagnostic *d, const char *text)
+{
+	diagnostic_list *list;
+	diagnostic *last;
+	int severity = DIAG_SEVERITY(d -> code);
+
+	if (Ctx != NULL && (severity == SEVERITY_ERROR || severity == SEVERITY_FATAL)) {
+		Ctx -> error_count++;
+	}
+	if (Ctx == NULL || Ctx -> buffer_log == 0) {
+		printDiagnostic(d, text);
+		return;
+	}
+
+	list = &Ctx -> diagnostics;
+	last = (list -> count > 0) ? &list -> items[list -> count - 1] : NULL;
+	d -> offset = Ctx -> log.size;
+	if (appendText(&Ctx -> log, text, d -> length) == 0) {
+		printDiagnostic(d, text);
+		return;
+	}
+
+	/* a progress message right after another one */
+	if (d -> code == DIAG_NONE && last != NULL && last -> code == DIAG_NONE && last -> offset + last -> length == d -> offset) {
+		last -> length += d -> length;
+		return;
+	}
+
+	if (list -> count == list -> capacity) {
+		int new_capacity = (list -> capacity == 0) ? DIAGNOSTICS_INIT_SIZE : list -> capacity * 2;
+		diagnostic *new_items = (diagnostic *) realloc(list -> items, new_capacity * sizeof(diagnostic));
+		TABLE_GROWTH();
+		if (new_items == NULL) {
+			Ctx -> log.size = d -> offset; /* take the text back out of the log */
+			Ctx -> log.text[d -> offset] = '\0';
+			printDiagnostic(d, text);
+			return;
+		}
+		list -> items = new_items;
+		list -> capacity = new_capacity;
+	}
+	list -> items[list -> count++] = *d;
+}
+
+
+/*
+ * formatDiagnostic - Formats a diagnostic, and keeps it in the log of the current context.
+ * @code: The code of the diagnostic.
+ * @line: The source line, 0 when it isn't about a single line.
+ * @format: The format of the diagnostic.
+ * @args: The arguments of the format.
+ * @args_again: The same arguments, for a diagnostic that doesn't fit in the small buffer.
+ */
+static void formatDiagnostic(int code, int line, const char *format, va_list args, va_list args_again)
+{
+	diagnostic d;
+	char small[256];
+	char *text = small;
+	int length;
+
+	/* format the diagnostic, most of them fit in the small buffer */
+	length = vsnprintf(small, sizeof(small), format, args);
+	if (length < 0) {
+		return; /* invalid format */
+	}
+	if (length >= (int) sizeof(small)) {
+		text = (char *) malloc(length + 1);
+		if (text == NULL) {
+			text = small; /* keep the beginning of the diagnostic */
+			length = sizeof(small) - 1;
+		} else {
+			vsnprintf(text, length + 1, format, args_again);
+		}
+	}
+
+	d.code = code;
+	d.line = line;
+	d.file = (Ctx != NULL) ? Ctx -> file_name : NULL;
+	d.offset = 0;
+	d.length = length;
+	storeDiagnostic(&d, text);
+
+	if (text != small) {
+		free(text);
+	}
+}
+
+
+/*
+ * logPrintf - Prints a progress message of the file being assembled, the same way "printf" does.
+ * @format: The format of the message.
+ *
+ * When the diagnostics of the current context are buffered, the message is kept in the log of
+ * the context, otherwise it's printed at once.
+ */
+void logPrintf(const char *format, ...)
+{
+	va_list args;
+	va_list args_again;
+
+	va_start(args, format);
+	va_start(args_again, format);
+	formatDiagnostic(DIAG_NONE, 0, format, args, args_again);
+	va_end(args_again);
+	va_end(args);
+}
+
+
+/*
+ * diagPrintf - Prints a diagnostic of the file being assembled, the same way "printf" does.
+ * @code: The code of the diagnostic (DIAG_...), its severity is told by the code.
+ * @line: The source line, 0 when it isn't about a single line.
+ * @format: The format of the diagnostic.
+ *
+ * When the diagnostics of the current context are buffered, the diagnostic is kept in the log of
+ * the context, otherwise it's printed at once.
+ */
+void diagPrintf(int code, int line, const char *format, ...)
+{
+	va_list args;
+	va_list args_again;
+
+	va_start(args, format);
+	va_start(args_again, format);
+	formatDiagnostic(code, line, format, args, args_again);
+	va_end(args_again);
+	va_end(args);
+}
+
+
+/*
+ * appendLog - Appends the diagnostics of another context to the log of the current context.
+ * @from: The context, its diagnostics are left as they are.
+ *
+ * The diagnostics keep their code, line and file, and their errors are counted in the current context.
+ */
+void appendLog(asm_context *from)
+{
+	int i;
+
+	for (i = 0; i < from -> diagnostics.count; i++) {
+		diagnostic d = from -> diagnostics.items[i];
+		storeDiagnostic(&d, from -> log.text + d.offset);
+	}
+}
+
+
+/*
+ * renderLog - Appends the buffered diagnostics of a context, in the format of the diagnostics, to a text buffer.
+ * @ctx: The context.
+ * @out: The text buffer.
+ *
+ * Return: 1 on success, 0 on memory error.
+ */
+int renderLog(asm_context *ctx, text_buffer *out)
+{
+	int i;
+
+	if (DIAG_FORMAT == DIAG_TEXT) {
+		return appendText(out, (ctx -> log.text != NULL) ? ctx -> log.text : "", ctx -> log.size);
+	}
+	for (i = 0; i < ctx -> diagnostics.count; i++) {
+		if (appendJson(out, &ctx -> diagnostics.items[i], ctx -> log.text + ctx -> diagnostics.items[i].offset) == 0) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+
+/*
+ * flushLog - Prints the buffered diagnostics of a context, and empties its log.
+ * @ctx: The context.
+ */
+void flushLog(asm_context *ctx)
+{
+	int i;
+
+	if (DIAG_FORMAT == DIAG_TEXT) {
+		if (ctx -> log.size > 0) {
+			fwrite(ctx -> log.text, 1, ctx -> log.size, DIAG_STDERR ? stderr : stdout);
+		}
+	} else {
+		for (i = 0; i < ctx -> diagnostics.count; i++) {
+			printDiagnostic(&ctx -> diagnostics.items[i], ctx -> log.text + ctx -> diagnostics.items[i].offset);
+		}
+	}
+	ctx -> log.size = 0;
+	ctx -> diagnostics.count = 0;
+	fflush(DIAG_STDERR ? stderr : stdout);
+}
+
+
+/*
+ * tooManyErrors - Checks if the file being assembled has reached the num of errors of "--max-errors".
+ * @file_name: Name of the input file, used in the diagnostics.
+ *
+ * The first time the limit is reached it's reported, the rest of the file is then skipped.
+ * NOTICE: a chunk of the first stage checks its own errors, the limit is reported by the file.
+ *
+ * Return: 1 if the file should be stopped, 0 otherwise.
+ */
+int tooManyErrors(char *file_name)
+{
+	if (MAX_ERRORS == 0 || Ctx -> error_count < MAX_ERRORS) {
+		return 0;
+	}
+	if (Ctx -> errors_capped == 0 && Ctx -> stage_chunk == 0) {
+		Ctx -> errors_capped = 1;
+		diagPrintf(DIAG_ERRORS_LIMIT, 0, "\nNOTICE: in file \"%s\", stopped after %d errors (\"--max-errors\"), the rest of the file is skipped.\n", file_name, MAX_ERRORS);
+	}
+	return 1;
+}
+
+
+#ifdef ASM_DEBUG_ALLOC
+#undef malloc
+#undef calloc
+#undef realloc
+
+/*
+ * debugMalloc - Counts a heap allocation of the current context, and allocates by "malloc".
+ */
+void *debugMalloc(size_t size)
+{
+	if (Ctx != NULL) {
+		Ctx -> heap_allocations++;
+	}
+	return malloc(size);
+}
+
+
+/*
+ * debugCalloc - Counts a heap allocation of the current context, and allocates by "calloc".
+ */
+void *debugCalloc(size_t count, size_t size)
+{
+	if (Ctx != NULL) {
+		Ctx -> heap_allocations++;
+	}
+	return calloc(count, size);
+}
+
+
+/*
+ * debugRealloc - Counts a heap allocation of the current context, and reallocates by "realloc".
+ */
+void *debugRealloc(void *p, size_t size)
+{
+	if (Ctx != NULL) {
+		Ctx -> heap_allocations++;
+	}
+	return realloc(p, size);
+}
+#endif
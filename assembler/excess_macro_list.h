@@ -4,66 +4,60 @@
  ~(This list contains assisting macros to help reduce the function lengths and make it more readable)~ */
 
 
-/* (used in "main" )*/
-#define MAIN_CLEAN_BEFORE_EXIT \
+/* (used in "main" and "assemble.c") */
+
+/* free all the tables of the file in the current context */
+#define FREE_FILE_TABLES \
     do { \
-        freeMacro(); \
-      	freeLabel(); \
+        freeLabel(); \
+		freeMacro();  \
 		freeDataImage(); \
 		freeInstructionImage(); \
+		freeFixupTable(); \
+		freeExternUses(); \
+		freeOutputPlan(); \
+		freeAmBuffer(); \
+		resetArena(&Ctx -> arena); \
+    } while (0)
+
+#define MAIN_CLEAN_BEFORE_EXIT \
+    do { \
+		FREE_FILE_TABLES; \
 		fclose(fd); \
     } while (0)
 
 #define MAIN_CLEANUP_AND_CONTINUE \
     do { \
-        freeLabel(); \
-		freeMacro();  \
-		freeDataImage(); \
-		freeInstructionImage(); \
+		FREE_FILE_TABLES; \
 		fclose(fd); \
     } while (0)
 
 
 /* (used in "first_stage.c") */
 
-/* Free memory, reset state, increment error count, and clear line. */
+/* Reset state and increment error count. */
 #define CLEANUP_AND_CONTINUE \
     do { \
-        free(dataOrString); \
-		free(entryOrExtern); \
         LABEL_FLAG = 0; \
 		L = 0; \
         err_count++; \
-        *line = '\0'; \
     } while (0)
 
 
-/* Free memory, reset state, and clear line on success. */
+/* Reset state on success, a successful line must not allocate (see ASM_DEBUG_ALLOC). */
 #define SUCCESS_AND_CONTINUE \
     do { \
-        free(dataOrString); \
-		free(entryOrExtern); \
+		ASSERT_NO_LINE_ALLOCATIONS; \
 		LABEL_FLAG = 0; \
 		L = 0; \
-		*line = '\0'; \
-    } while (0)
-
-
-/* Free memory and close file before exiting. */
-#define CLEAN_BEFORE_EXIT \
-    do { \
-        free(dataOrString); \
-		free(entryOrExtern); \
-		fclose(fp); \
     } while (0)
 
 
-/* allocate node and check for memory fault. */
-#define ALLOCATE_NODE \
-	Iptr t = (Iptr) malloc(sizeof(I_item)); \
-	if (!t) { \
+/* store the memory cell in the instruction image and check for memory fault. */
+#define STORE_MILA(IC) \
+	if (setInstructionCell(IC, space) == 0) { \
 		return 0; \
-	} 
+	}
 
 
 /* (used in "first_stage_func.c") */
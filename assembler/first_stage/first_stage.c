@@ -1,6 +1,6 @@
 /*
  * first_stage.c - First stage function for the assembler project
- * This file contains the first stage function which processes a given input file (.am),
+ * This file contains the first stage function which processes the expanded source (.am) of a given input file,
  * handling label definitions, .data, .string, .entry, and .extern directives, and generating
  * the intermediate code and data images for further assembly stages.
  */
@@ -8,14 +8,53 @@
 #include "../assembler.h"
 #include "../excess_macro_list.h"
 #include "../../pre_processing/macros_table.h" 
+#include "../../pre_processing/pre_assembler.h"
 
 
 /*
  * first_stage - Handles the first stage of the assembler process.
  * @file_name: Name of the input file to be processed.
- * 
- * This function processes the .am file line by line, handling label definitions, 
- * .data, .string, .entry, and .extern directives. It updates the instruction counter (IC) 
+ *
+ * A large expanded source is split into chunks that are processed by several threads ("--stage-threads"),
+ * otherwise all of its lines are processed here, in order.
+ *
+ * Return: 0 - regular error
+ *         1 - success
+ *         2 - memory error
+ */
+int first_stage(char *file_name)
+{
+	int IC = 0; /* instruction counter */
+	int DC = 0; /* data counter */
+	int first_stageErrorType;
+
+	if (STAGE_THREADS > 1 && Ctx -> am_buffer.size >= 2 * STAGE_CHUNK_MIN_SIZE) {
+		return first_stage_chunks(file_name);
+	}
+
+	first_stageErrorType = first_stage_lines(file_name, 0, Ctx -> am_buffer.size, 0, &IC, &DC);
+	if (first_stageErrorType != 1) {
+		return first_stageErrorType;
+	}
+
+	/* Update all ".data" & ".string" labels with IC+FIRST_ADDRESS, and update all .code labels with +FIRST_ADDRESS */
+	updateLabels(IC);
+
+	return 1; /* success */
+}
+
+
+/*
+ * first_stage_lines - Processes a range of lines of the expanded source.
+ * @file_name: Name of the input file to be processed.
+ * @pos: The position of the first line in the expanded source.
+ * @end: The position right after the last line.
+ * @line_num: The num of lines before the range (the line numbers of the messages).
+ * @IC_out: Filled with the instruction counter after the range.
+ * @DC_out: Filled with the data counter after the range.
+ *
+ * This function processes the lines one by one, every line is tokenized once and then handled
+ * by its kind: label definitions, instructions, .data, .string, .entry, and .extern directives. It updates the instruction counter (IC) 
  * and data counter (DC) and generates the intermediate code and data images.
  * The function returns different values based on the type of error encountered or success.
  * 
@@ -23,54 +62,50 @@
  *         1 - success
  *         2 - memory error
  */ 
-int first_stage(char *file_name)
+int first_stage_lines(char *file_name, int pos, int end, int line_num, int *IC_out, int *DC_out)
 {
 	int err_count = 0;
 	int LABEL_FLAG = 0;
 	int IC = 0; /* instruction counter */
 	int DC = 0; /* data counter */
 	int L = 0; /* words counter */
-	int line_num = 0;
+	line_ir ir; /* the current line, tokenized */
+	line_view view;
 
-	/* open .am file */
-    char src_filename[256];	
-	sprintf(src_filename, "pre_processing/%s.am", file_name);
+	/* Reading line after line, straight from the expanded source of the pre-assembler */
+	while (nextLine(Ctx -> am_buffer.text, end, &pos, &view))
+	{
+		int label_err;
+		int entry_err;
 
-	FILE *fp = fopen(src_filename, "r"); 
-	if (fp == NULL) {
-		printf("ERROR: Unable to open file: \"%s.am\".\n", file_name);
-		return 0;
-	}	
+		/* check if the file already has too many errors ("--max-errors") */
+		if (tooManyErrors(file_name)) {
+			err_count++;
+			break;
+		}
 
-	/* Reading line after line */
-	char line[LINE_SIZE]; 
-	while (fgets(line, sizeof(line), fp)) 
-	{
-		/* check if we surpassed the memory size limit */
-		if (IC + DC > MEMORY_SIZE) {
-			printf("\nERROR: in file %s, file size is too big, surpassing memory limit of 4096.\n", file_name);
+		/* check if we surpassed the memory size limit, the program is loaded at FIRST_ADDRESS */
+		if (FIRST_ADDRESS + IC + DC > MEMORY_WORDS && Ctx -> stage_chunk == 0) {
+			diagPrintf(DIAG_MEMORY_LIMIT, 0, "\nERROR: in file %s, file size is too big, surpassing memory limit of %d.\n", file_name, MEMORY_WORDS);
 			err_count++;
 			break;
 		}
 
 		line_num++; /* First line is 1 */	
-		int label_err = isLabel(line, file_name, line_num);	
-		char *dataOrString = findDataOrStringWord(line, file_name, line_num);
-		char *entryOrExtern = findEntryOrExternWord(line, file_name, line_num);
-	
-		/* Reading the first word in a line. */
-		char *first_word = get_first_word(line); 
-		if (first_word == NULL || strcmp(first_word, "") == 0 || *first_word == '\n') {
-            continue; /* Skip blank lines */
+		LINE_ALLOCATIONS_BEGIN;
+
+		/* scan the line once, all the checks below work on its words */
+		tokenizeLine(view.start, view.length, &ir);
+		if (ir.kind == LINE_BLANK || ir.kind == LINE_COMMENT) {
+            continue; /* Skip blank lines and comments */
         }
+
+		label_err = isLabel(&ir, file_name, line_num);	
+		entry_err = checkEntryOrExtern(&ir, file_name, line_num);
 		
 		/* --(PRE-ERROR Checking)-- */
-		if (line[0] == ';') { /* ignore comments*/
-			*line = '\0';
-			continue;
-		}
 		/* check that "macro" or macro name or a label is not later in line */
-		if (clearOfMacro(line, file_name, line_num) == 0) {  
+		if (clearOfMacro(&ir, file_name, line_num) == 0) {  
 			CLEANUP_AND_CONTINUE;
 			continue; /* regular error */
 		}
@@ -85,47 +120,41 @@ int first_stage(char *file_name)
 		}
 
 		/* --(check if it's .data or .string)-- */
-		if (dataOrString != NULL) {
+		if (ir.kind == LINE_DATA || ir.kind == LINE_STRING) {
 
-			if (*dataOrString == '0') {
-				CLEAN_BEFORE_EXIT; 
-				return 2; /* memory error */
-			}
+			int dataOrString = (ir.kind == LINE_DATA) ? LABEL_DATA : LABEL_STRING;
 			
 			/* add label to table if exists */		
 			if (LABEL_FLAG == 1) {
 				/* put in the Label table with .data, value will be DC. */ 
-				char *label = get_first_word(line);
-				label[strlen(label)-1] = '\0';
+				char *label = ir.words[0];
 
 				/* check that the label isn't defined twice */
 				if (isAlreadyLabel(label) == 1) {
-					printf("\nERROR: in file %s, line %d, the label \"%s\" is defined more than once.\n", file_name, line_num, label);
+					diagPrintf(DIAG_LABEL_REDEFINED, line_num, "\nERROR: in file %s, line %d, the label \"%s\" is defined more than once.\n", file_name, line_num, label);
 					CLEANUP_AND_CONTINUE;
 					continue; /* regular error */
 				}
 	
 				/* add the label to the table ;) */
 				if (addLabel(label, DC,  dataOrString, file_name, line_num) == 0) {
-					printf("\nERROR: in file %s, line %d, unable to allocate memory for label \"%s\".\n", file_name, line_num, label);
-					CLEAN_BEFORE_EXIT;
+					diagPrintf(DIAG_NO_MEMORY, line_num, "\nERROR: in file %s, line %d, unable to allocate memory for label \"%s\".\n", file_name, line_num, label);
 					return 2; /* memory error */
 				}
 			}
 
 			/* encode .data instruction to the Data-Image. */
-			if (strcmp(dataOrString, ".data") == 0) { 
-				int newDC = encodeData(line, DC, dataOrString, LABEL_FLAG);
+			if (ir.kind == LINE_DATA) { 
+				int newDC = encodeData(ir.args, DC, ir.kind);
 				
 				/* error checking: */
 				if (newDC == -1) {
-					printf("\nERROR: in file %s, line %d, while encoding .data.\n", file_name, line_num);
+					diagPrintf(DIAG_DATA, line_num, "\nERROR: in file %s, line %d, while encoding .data.\n", file_name, line_num);
 					CLEANUP_AND_CONTINUE;
 					continue; /* regular error */
 				} 
 				else if (newDC == -2) {
-					printf("\nERROR: in file %s, line %d, memory error while encoding .data.\n", file_name, line_num);
-					CLEAN_BEFORE_EXIT;
+					diagPrintf(DIAG_NO_MEMORY, line_num, "\nERROR: in file %s, line %d, memory error while encoding .data.\n", file_name, line_num);
 					return 2; /* memory error */
 				}
 				
@@ -135,17 +164,16 @@ int first_stage(char *file_name)
 			}
 
 			/* encode .string instruction to the Data-Image */
-			else if (strcmp(dataOrString, ".string") == 0) {
-				int newDC = encodeData(line, DC, dataOrString, LABEL_FLAG);
+			else {
+				int newDC = encodeData(ir.args, DC, ir.kind);
 				/* error checking: */
 				if (newDC == -1) {
-					printf("\nERROR: in file %s, line %d, while encoding .string\n", file_name, line_num);		
+					diagPrintf(DIAG_DATA, line_num, "\nERROR: in file %s, line %d, while encoding .string\n", file_name, line_num);		
 					CLEANUP_AND_CONTINUE;
 					continue; /* regular error */
 				} 
 				else if (newDC == -2) {
-					printf("\nERROR: in file %s, line %d, memory error while encoding .string\n", file_name, line_num);
-					CLEAN_BEFORE_EXIT;
+					diagPrintf(DIAG_NO_MEMORY, line_num, "\nERROR: in file %s, line %d, memory error while encoding .string\n", file_name, line_num);
 					return 2; /* memory error */
 				}
 
@@ -156,28 +184,28 @@ int first_stage(char *file_name)
 		}
 			
 		/* --(check if it's .entry or .extern)-- */
-		if (entryOrExtern != NULL) {
+		if (ir.kind == LINE_ENTRY || ir.kind == LINE_EXTERN) {
 
-			if (*entryOrExtern == '0') {
-				CLEAN_BEFORE_EXIT; /* memory error */
-				return 2; /* memory error */
-			} 
-			else if (*entryOrExtern == '1') {
+			if (entry_err == 0) {
 				CLEANUP_AND_CONTINUE;
 				continue; /* regular error */
 			}
 
+			/* a (possible) label that's defined before .entry or .extern is ignored */
+			if (label_err == 3) {
+				diagPrintf(DIAG_LABEL_IGNORED, line_num, "\nNOTICE: in file \"%s\", line %d, the (possible) label that's defined as a first word will not be considered as label in the label table.\n", file_name, line_num);
+			}
+
 			/* add .extern instruction to the Label Table. */
-			if (strcmp(entryOrExtern, ".extern") == 0) {
+			if (ir.kind == LINE_EXTERN) {
 				
 				/* put one or more labels into the table without a value, with type .external */
-				int extern_err = addExtern(line, file_name, line_num, label_err); 
+				int extern_err = addExtern(&ir, file_name, line_num, label_err); 
 				if (extern_err == 0) {
 					CLEANUP_AND_CONTINUE;
 					continue; /* regular error */
 				}
 				else if (extern_err == 2) {
-					CLEAN_BEFORE_EXIT;
 					return 2; /* memory error */
 				}
 
@@ -185,98 +213,69 @@ int first_stage(char *file_name)
 				continue;
 			}
 			
+			/* record the .entry instruction, the label status is changed on the second stage */
+			if (addEntryFixup(&ir, line_num) == 0) {
+				diagPrintf(DIAG_NO_MEMORY, line_num, "\nERROR: in file %s, line %d, unable to allocate memory for \".entry\".\n", file_name, line_num);
+				return 2; /* memory error */
+			}
+
 			SUCCESS_AND_CONTINUE;
 			continue;			
 		}
 		
-		/* if LABEL_FLAG turned on, then put it in the label table with type .code with a value of IC+100 */
+		/* if LABEL_FLAG turned on, then put it in the label table with type .code with a value of IC+FIRST_ADDRESS */
 		if (LABEL_FLAG == 1) {
 
 			/* load the label to the table */
-			char *second_word = get_second_word(line);
-			char *label = get_first_word(line);
-			label[strlen(label)-1] = '\0';
+			char *label = ir.words[0];
 
 			/* check that the label isn't defined twice */
 			if (isAlreadyLabel(label) == 1) {
-				printf("\nERROR: in file %s, line %d, the label \"%s\" is defined more than once.\n", file_name, line_num, label);
+				diagPrintf(DIAG_LABEL_REDEFINED, line_num, "\nERROR: in file %s, line %d, the label \"%s\" is defined more than once.\n", file_name, line_num, label);
 				CLEANUP_AND_CONTINUE;
 				continue; /* regular error */
 			}
 	
 			/* add the label to the table */
-			if (addLabel(label, IC + 100, ".code", file_name, line_num) == 0) {
-				printf("\nERROR: in file %s, line %d, unable to allocate memory for label \"%s\".\n", file_name, line_num, label);
-				CLEAN_BEFORE_EXIT;
+			if (addLabel(label, IC + FIRST_ADDRESS, LABEL_CODE, file_name, line_num) == 0) {
+				diagPrintf(DIAG_NO_MEMORY, line_num, "\nERROR: in file %s, line %d, unable to allocate memory for label \"%s\".\n", file_name, line_num, label);
 				return 2; /* memory error */
 			}
 
 			/* check that the instruction type is valid */
-			if (validInstructionName(second_word) == 0) {
-				printf("\nERROR: in file %s, line %d, instruction word of type \"%s\" that comes after the label is unknown.\n", file_name, line_num, second_word);
+			if (ir.opcode == -1) {
+				diagPrintf(DIAG_UNKNOWN_INSTRUCTION, line_num, "\nERROR: in file %s, line %d, instruction word of type \"%s\" that comes after the label is unknown.\n", file_name, line_num, ir.keyword);
 				CLEANUP_AND_CONTINUE;
 				continue; /* regular error */
 			}
-
-			/* encode the instruction (with a label) */
-			L = encodeInstruction(line, file_name, line_num, LABEL_FLAG, IC);
-			if (L == -1) {
-				CLEANUP_AND_CONTINUE;
-				continue; /* regular error */
-			}
-			else if (L == -2) {
-				CLEAN_BEFORE_EXIT;
-				return 2; /* memory error */
-			}
-
-			IC += L; 
-			/* in case there are two registers on the same line, decrease IC as they will be encoded both in the same "mila" */
-			if (isAddressType2Or3(line, file_name, line_num) == 1) {
-				IC--;
-			}
-
-			SUCCESS_AND_CONTINUE;
-			continue;
 		}
 
 		/* check that the instruction type is valid */
-		if (validInstructionName(first_word) == 0 && !LABEL_FLAG) {
-			printf("\nERROR: in file %s, line %d, instruction word of type \"%s\" is unknown.\n", file_name, line_num, first_word);
+		else if (ir.opcode == -1) {
+			diagPrintf(DIAG_UNKNOWN_INSTRUCTION, line_num, "\nERROR: in file %s, line %d, instruction word of type \"%s\" is unknown.\n", file_name, line_num, ir.keyword);
 			CLEANUP_AND_CONTINUE;
 			continue; /* regular error */
 		}
 
-		/* encode the instruction (without a label) */
-		L = encodeInstruction(line, file_name, line_num, LABEL_FLAG, IC);
+		/* encode the instruction, L already counts two register operands as a single word */
+		L = encodeInstruction(&ir, file_name, line_num, IC);
 		if (L == -1) {
 			CLEANUP_AND_CONTINUE;
 			continue; /* regular error */
 		}
 		else if (L == -2) {
-			CLEAN_BEFORE_EXIT;
 			return 2; /* memory error */
 		}
 		
 		IC += L;
-		/* in case there are two registers on the same line, decrease IC as they will be encoded both in the same "mila" */
-		if (isAddressType2Or3(line, file_name, line_num) == 1) {
-			IC--;
-		} 
-		
 		SUCCESS_AND_CONTINUE;
 	}	
 
 	/* at this point we read all the lines */
-	fclose(fp);
+	*IC_out = IC;
+	*DC_out = DC;
 	if (err_count > 0) {
 		return 0;
 	}
-
-	/* Update all ".data" & ".string" labels with IC+100, and update all .code labels with +100 */
-	updateLabels(IC);
-	
 	return 1; /* success */
-} 
-
-
-
+}
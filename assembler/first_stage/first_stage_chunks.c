@@ -0,0 +1,424 @@
+/*
+ * first_stage_chunks.c - This file contains the parallel first stage of a single large file ("--stage-threads").
+ * The expanded source is split at line boundaries into chunks. The first chunk is processed in the context of
+ * the file, and each of the others in a context of its own, by a thread of its own, with chunk-relative IC and DC
+ * and a symbol table of its own. A chunk (but the first) doesn't encode any label operand: they are all left to
+ * its fixup table, since the label may be defined by an earlier chunk.
+ * The chunks are then merged in order: their images are moved by the prefix sums of the IC and DC of the chunks
+ * before them, and their labels are added to the symbol table of the file. A fixup whose label was already defined
+ * by then is encoded right away, just as the first stage would have encoded it, the rest are left to the second
+ * stage. Every message keeps the real line number, and the messages of the chunks are printed in order.
+ * The first stage stops at the very line that surpasses the memory limit (or the error limit), and skips the whole
+ * line of a label that's already defined, which a chunk can't tell on its own. So when a merge has messages of its
+ * own, or the file surpasses one of the limits, the chunks are dropped and the first stage runs again on the whole
+ * file, in order.
+ */
+
+#include <pthread.h>
+#include "../assembler.h"
+#include "../excess_macro_list.h"
+#include "../../pre_processing/macros_table.h"
+#include "../../pre_processing/pre_assembler.h"
+
+
+int STAGE_THREADS = 1; /* set by "--stage-threads" */
+
+/* this struct defines the diagnostics of a file before its first stage */
+typedef struct {
+	int log_size;
+	int num_of_messages;
+	int error_count;
+	int errors_capped;
+} stage_start;
+
+/*
+ * runChunk - Runs the first stage on the lines of a chunk, in the context of the chunk.
+ * @arg: The chunk.
+ *
+ * Return: NULL.
+ */
+void *runChunk(void *arg)
+{
+	stage_chunk *chunk = (stage_chunk *) arg;
+
+	Ctx = chunk -> ctx;
+	chunk -> result = first_stage_lines(chunk -> file_name, chunk -> start, chunk -> end, chunk -> line_num, &chunk -> IC, &chunk -> DC);
+	Ctx = NULL;
+	return NULL;
+}
+
+
+/*
+ * newChunkContext - Creates the context of a chunk, it shares the expanded source and the macros of the file.
+ * @file_ctx: The context of the file.
+ *
+ * Return: The new context, NULL on memory error.
+ */
+asm_context *newChunkContext(asm_context *file_ctx)
+{
+	asm_context *ctx = newContext(1);
+	if (ctx == NULL) {
+		return NULL;
+	}
+	ctx -> am_buffer = file_ctx -> am_buffer;
+	ctx -> macros = file_ctx -> macros;
+	ctx -> file_name = file_ctx -> file_name;
+	ctx -> stage_chunk = 1;
+	return ctx;
+}
+
+
+/*
+ * freeChunkContext - Frees the context of a chunk, without the expanded source and the macros of the file.
+ * @ctx: The context of the chunk (may be NULL).
+ */
+void freeChunkContext(asm_context *ctx)
+{
+	asm_context *file_ctx = Ctx;
+
+	if (ctx == NULL) {
+		return;
+	}
+	memset(&ctx -> am_buffer, 0, sizeof(text_buffer));
+	memset(&ctx -> macros, 0, sizeof(macro_table));
+
+	Ctx = ctx;
+	FREE_FILE_TABLES;
+	Ctx = file_ctx;
+	freeContext(ctx);
+}
+
+
+/*
+ * dropFirstStage - Drops the tables and the diagnostics of the first stage of the file, in the current context.
+ * @start: The diagnostics of the file before its first stage.
+ *
+ * The expanded source and the macros are kept, the first stage may run again on them.
+ */
+static void dropFirstStage(const stage_start *start)
+{
+	freeLabel();
+	freeDataImage();
+	freeInstructionImage();
+	freeFixupTable();
+	freeExternUses();
+	freeOutputPlan();
+
+	Ctx -> log.size = start -> log_size;
+	if (Ctx -> log.text != NULL) {
+		Ctx -> log.text[start -> log_size] = '\0';
+	}
+	Ctx -> diagnostics.count = start -> num_of_messages;
+	Ctx -> error_count = start -> error_count;
+	Ctx -> errors_capped = start -> errors_capped;
+}
+
+
+/*
+ * mergeLabels - Adds the labels of a chunk to the symbol table of the file.
+ * @chunk: The chunk.
+ * @IC: The num of instruction words before the chunk.
+ * @DC: The num of data words before the chunk.
+ *
+ * A label that is already defined by an earlier chunk is reported on its own line, just as the first stage does.
+ *
+ * Return: 1 on success, 0 on regular error, 2 on memory error.
+ */
+static int mergeLabels(stage_chunk *chunk, int IC, int DC)
+{
+	int err_count = 0;
+	int i;
+
+	for (i = 0; i < chunk -> ctx -> symbols.labels_count; i++) {
+		Lptr p = &chunk -> ctx -> symbols.labels[i];
+		char *name = chunk -> ctx -> symbols.names[p -> name_id].name;
+		int line_num = p -> line_num + chunk -> line_offset;
+		int value = p -> value;
+
+		if (isAlreadyLabel(name) == 1) {
+			if (p -> kind == LABEL_EXTERNAL) {
+				diagPrintf(DIAG_LABEL_REDEFINED, line_num, "\nERROR: in file \"%s\", line %d, the label is already defined.\n", chunk -> file_name, line_num);
+			} else {
+				diagPrintf(DIAG_LABEL_REDEFINED, line_num, "\nERROR: in file %s, line %d, the label \"%s\" is defined more than once.\n", chunk -> file_name, line_num, name);
+			}
+			err_count++;
+			continue;
+		}
+
+		if (p -> kind == LABEL_CODE) {
+			value += IC;
+		}
+		else if (p -> kind == LABEL_DATA || p -> kind == LABEL_STRING) {
+			value += DC;
+		}
+		if (addLabel(name, value, p -> kind, chunk -> file_name, line_num) == 0) {
+			return 2; /* memory error */
+		}
+	}
+	return (err_count > 0) ? 0 : 1;
+}
+
+
+/*
+ * mergeFixups - Adds the fixups of a chunk to the fixup table of the file, or encodes them.
+ * @chunk: The chunk.
+ * @IC: The num of instruction words before the chunk.
+ *
+ * An operand whose label is defined on an earlier line (or the same line) is encoded now, as the first stage
+ * encodes a label it already knows, the other fixups are left to the second stage.
+ *
+ * Return: 1 on success, 0 on regular error, 2 on memory error.
+ */
+static int mergeFixups(stage_chunk *chunk, int IC)
+{
+	fixup_table *table = &chunk -> ctx -> fixup_table;
+	int err_count = 0;
+	int i;
+
+	for (i = 0; i < table -> size; i++) {
+		fixup *f = &table -> items[i];
+		char *name = chunk -> ctx -> symbols.names[f -> name_id].name;
+		int line_num = f -> line_num + chunk -> line_offset;
+
+		if (f -> kind == FIXUP_OPERAND) {
+			Lptr label = findLabel(name);
+
+			if (label != NULL && label -> line_num <= line_num) {
+				int encode_err = encodeLabelMila(label, IC + f -> address);
+				if (encode_err == 0) {
+					return 2; /* memory error */
+				}
+				else if (encode_err == 2) {
+					diagPrintf(DIAG_LABEL_ADDRESS, line_num, "\nERROR: in file \"%s\", line %d, the address %d of label \"%s\" doesn't fit in an operand word (at most %d).\n", chunk -> file_name, line_num, label -> value, name, MAX_LABEL_ADDRESS);
+					err_count++;
+				}
+				continue;
+			}
+		}
+		if (addFixup(f -> kind, (f -> kind == FIXUP_OPERAND) ? IC + f -> address : 0, name, line_num, f -> opcode, f -> operand) == 0) {
+			return 2; /* memory error */
+		}
+	}
+	return (err_count > 0) ? 0 : 1;
+}
+
+
+/*
+ * mergeChunk - Merges a chunk into the context of the file.
+ * @chunk: The chunk.
+ * @IC: The num of instruction words before the chunk.
+ * @DC: The num of data words before the chunk.
+ *
+ * The chunk itself is left as it is, a segment of an incremental session (see assemble.c) is merged again
+ * after every edit, its labels and fixups moved by its line offset (the offset is 0 for the chunks of a file).
+ *
+ * Return: 1 on success, 0 on regular error, 2 on memory error.
+ */
+int mergeChunk(stage_chunk *chunk, int IC, int DC)
+{
+	asm_context *ctx = chunk -> ctx;
+	int label_err, fixup_err;
+	int i;
+
+	/* the messages of the chunk come right after the messages of the chunks before it */
+	appendLog(ctx);
+
+	/* the words of the chunk, at their place in the images of the file */
+	for (i = 0; i < ctx -> instruction_image.size; i++) {
+		if (((ctx -> instruction_image.encoded[i / 8] >> (i % 8)) & 1) &&
+			setInstructionCell(IC + i, ctx -> instruction_image.cells[i]) == 0) {
+			return 2; /* memory error */
+		}
+	}
+	for (i = 0; i < ctx -> data_image.size; i++) {
+		if (setDataCell(DC + i, ctx -> data_image.cells[i]) == 0) {
+			return 2; /* memory error */
+		}
+	}
+
+	label_err = mergeLabels(chunk, IC, DC);
+	if (label_err == 2) {
+		return 2;
+	}
+	fixup_err = mergeFixups(chunk, IC);
+	if (fixup_err == 2) {
+		return 2;
+	}
+
+	/* the counters of the chunk ("--stats") */
+	Ctx -> stats.label_lookups += ctx -> stats.label_lookups;
+	Ctx -> stats.macro_lookups += ctx -> stats.macro_lookups;
+	Ctx -> stats.list_walks += ctx -> stats.list_walks;
+	Ctx -> stats.allocations += ctx -> stats.allocations;
+
+	return (chunk -> result == 1 && label_err == 1 && fixup_err == 1) ? 1 : 0;
+}
+
+
+/*
+ * first_stage_chunks - Handles the first stage of a large file by several threads.
+ * @file_name: Name of the input file to be processed.
+ *
+ * The expanded source is split into up to STAGE_THREADS chunks of at least STAGE_CHUNK_MIN_SIZE characters.
+ * The first chunk is processed in the context of the file, so when it surpasses one of the limits the chunks
+ * after it are not merged (nor are their messages printed). Any other chunk that surpasses a limit, or whose
+ * merge has messages, is left to a first stage of the whole file (see the top of the file).
+ *
+ * Return: 0 - regular error
+ *         1 - success
+ *         2 - memory error
+ */
+int first_stage_chunks(char *file_name)
+{
+	asm_context *file_ctx = Ctx;
+	const char *text = Ctx -> am_buffer.text;
+	int size = Ctx -> am_buffer.size;
+	int num_of_chunks = (size / STAGE_CHUNK_MIN_SIZE < STAGE_THREADS) ? size / STAGE_CHUNK_MIN_SIZE : STAGE_THREADS;
+	stage_chunk *chunks = (stage_chunk *) calloc(num_of_chunks, sizeof(stage_chunk));
+	pthread_t *threads = (pthread_t *) malloc(num_of_chunks * sizeof(pthread_t));
+	char *started = (char *) calloc(num_of_chunks, 1);
+	int memory_err = 0;
+	int limit_err = 0; /* 1 - the memory limit was surpassed, and reported */
+	int restart = 0; /* 1 - the first stage runs again on the whole file */
+	stage_start start;
+	int err_count = 0;
+	int IC = 0, DC = 0;
+	int line_num = 0;
+	int pos = 0;
+	int i, n = 0;
+
+	STAT_COUNT(allocations);
+	if (chunks == NULL || threads == NULL || started == NULL) {
+		free(chunks);
+		free(threads);
+		free(started);
+		diagPrintf(DIAG_NO_MEMORY, 0, "\nERROR: in file %s, unable to allocate memory for the first stage.\n", file_name);
+		return 2; /* memory error */
+	}
+	start.log_size = Ctx -> log.size;
+	start.num_of_messages = Ctx -> diagnostics.count;
+	start.error_count = Ctx -> error_count;
+	start.errors_capped = Ctx -> errors_capped;
+
+	/* --(split the expanded source at line boundaries, and count the lines before every chunk)-- */
+	for (i = 0; i < num_of_chunks && pos < size; i++) {
+		int end = (i == num_of_chunks - 1) ? size : (int) ((long) size * (i + 1) / num_of_chunks);
+		const char *newline;
+
+		/* the chunk ends right after the end of a line */
+		if (end < size && (newline = memchr(text + end, '\n', size - end)) != NULL) {
+			end = newline - text + 1;
+		} else {
+			end = size;
+		}
+
+		chunks[n].file_name = file_name;
+		chunks[n].start = pos;
+		chunks[n].end = end;
+		chunks[n].line_num = line_num;
+		while (pos < end && (newline = memchr(text + pos, '\n', end - pos)) != NULL) {
+			pos = newline - text + 1;
+			line_num++;
+		}
+		pos = end;
+		n++;
+	}
+
+	/* --(run every chunk but the first by a thread of its own, in a context of its own)-- */
+	for (i = 1; i < n && memory_err == 0; i++) {
+		chunks[i].ctx = newChunkContext(file_ctx);
+		if (chunks[i].ctx == NULL) {
+			memory_err = 1;
+			break;
+		}
+		started[i] = (pthread_create(&threads[i], NULL, runChunk, &chunks[i]) == 0);
+	}
+
+	/* the first chunk is processed here, in the context of the file */
+	chunks[0].ctx = file_ctx;
+	chunks[0].result = first_stage_lines(file_name, chunks[0].start, chunks[0].end, 0, &chunks[0].IC, &chunks[0].DC);
+	IC = chunks[0].IC;
+	DC = chunks[0].DC;
+	if (chunks[0].result == 2) {
+		memory_err = 1;
+	}
+	else if (chunks[0].result == 0) {
+		err_count++;
+		limit_err = (FIRST_ADDRESS + IC + DC > MEMORY_WORDS); /* the first chunk checks the memory limit by itself */
+	}
+
+	/* --(merge the chunks in order)-- */
+	for (i = 1; i < n; i++) {
+		int num_of_messages; /* the messages of the file once the messages of the chunk are appended */
+		int merge_err;
+
+		if (chunks[i].ctx == NULL) {
+			continue; /* never created, there was a memory error */
+		}
+		if (started[i]) {
+			pthread_join(threads[i], NULL);
+		} else {
+			runChunk(&chunks[i]); /* no thread, process the chunk here */
+			Ctx = file_ctx;
+		}
+		if (memory_err == 1 || limit_err == 1 || restart == 1) {
+			continue;
+		}
+		if (tooManyErrors(file_name)) {
+			err_count++;
+			continue; /* the rest of the file is skipped ("--max-errors"), the first chunk reached the limit */
+		}
+		if (chunks[i].result == 2) {
+			appendLog(chunks[i].ctx); /* the memory error of the chunk */
+			memory_err = 1;
+			continue;
+		}
+
+		num_of_messages = Ctx -> diagnostics.count + chunks[i].ctx -> diagnostics.count;
+		merge_err = mergeChunk(&chunks[i], IC, DC);
+		if (merge_err == 2) {
+			memory_err = 1;
+			continue;
+		}
+		IC += chunks[i].IC;
+		DC += chunks[i].DC;
+
+		if (Ctx -> diagnostics.count > num_of_messages || FIRST_ADDRESS + IC + DC > MEMORY_WORDS || (MAX_ERRORS > 0 && Ctx -> error_count >= MAX_ERRORS)) {
+			restart = 1;
+		}
+		else if (merge_err == 0) {
+			err_count++;
+		}
+	}
+
+	for (i = 1; i < n; i++) {
+		freeChunkContext(chunks[i].ctx);
+	}
+	free(chunks);
+	free(threads);
+	free(started);
+
+	if (memory_err == 1) {
+		return 2; /* memory error */
+	}
+
+	/* --(run the first stage again on the whole file, in order)-- */
+	if (restart == 1) {
+		int stage_err;
+
+		dropFirstStage(&start);
+		IC = DC = 0;
+		stage_err = first_stage_lines(file_name, 0, size, 0, &IC, &DC);
+		if (stage_err != 1) {
+			return stage_err;
+		}
+	}
+	else if (err_count > 0) {
+		return 0;
+	}
+
+	/* Update all ".data" & ".string" labels with IC+FIRST_ADDRESS, and update all .code labels with +FIRST_ADDRESS */
+	updateLabels(IC);
+
+	return 1; /* success */
+}
@@ -0,0 +1,222 @@
+/*
+ * line_ir.c - This file contains the tokenizer of the assembler.
+ * Every source line is scanned exactly once into a line record (line_ir): its words, the label
+ * definition, the kind of the line (instruction or directive), the opcode, the comma separated
+ * operands with their addressing modes and the num of machine words the line takes.
+ * The stages of the assembler work on that record instead of rescanning the raw text.
+ */
+
+#include "assembler.h"
+
+
+/*
+ * operandMode - Returns the addressing mode of an operand by its spelling.
+ * @operand: The operand to be checked.
+ *
+ * The mode is decided by the spelling alone: a valid immediate number or register name inside
+ * the operand, or whether a direct operand is a known label, is checked later by "getAddressingType".
+ *
+ * Return: ADDR_IMMEDIATE, ADDR_DIRECT, ADDR_INDIRECT or ADDR_REGISTER.
+ */
+static int operandMode(const char *operand)
+{
+	if (operand[0] == '#') {
+		return ADDR_IMMEDIATE;
+	}
+	if (operand[0] == '*') {
+		return ADDR_INDIRECT;
+	}
+	if (operand[0] == 'r' && operand[1] >= '0' && operand[1] <= '7' && operand[2] == '\0') {
+		return ADDR_REGISTER;
+	}
+	return ADDR_DIRECT; /* a label, or an unknown word */
+}
+
+
+/*
+ * tokenizeOperands - Splits the text after an instruction word into comma separated operands.
+ * @ir: The line record, its "args" text is split.
+ *
+ * Operands are separated by exactly one comma, with optional whitespaces around it.
+ * A comma at the beginning or at the end, two consecutive commas, or two operands without a
+ * comma between them turn "commas_ok" off.
+ */
+static void tokenizeOperands(line_ir *ir)
+{
+	const char *p = ir -> args;
+	char *out = ir -> operand_text;
+
+	ir -> num_of_operands = 0;
+	ir -> commas_ok = 1;
+
+	if (*p == '\0') {
+		return; /* no operands */
+	}
+
+	while (1)
+	{
+		const char *start = p;
+		int length;
+
+		/* find the end of the operand */
+		while (*p && !IS_SEPARATOR(*p)) {p++; }
+		length = p - start;
+		if (length == 0) {
+			ir -> commas_ok = 0; /* a missing operand around a comma */
+			return;
+		}
+
+		/* save the operand */
+		if (ir -> num_of_operands < MAX_OPERANDS) {
+			memcpy(out, start, length);
+			out[length] = '\0';
+			ir -> operands[ir -> num_of_operands] = out;
+			ir -> addressing[ir -> num_of_operands] = operandMode(out);
+			out += length + 1;
+		}
+		ir -> num_of_operands++;
+
+		while (*p && IS_SPACE(*p)) {p++; }
+		if (*p == '\0') {
+			return; /* end of the operands */
+		}
+		if (*p != ',') {
+			ir -> commas_ok = 0; /* no comma seperating the operands */
+			return;
+		}
+		p++; /* skip the comma */
+		while (*p && IS_SPACE(*p)) {p++; }
+	}
+}
+
+
+/*
+ * tokenizeLine - Scans a source line into a line record.
+ * @line: The start of the line, it doesn't have to be null-terminated.
+ * @len: The num of characters that may be read, the line also ends at '\n' or '\0'.
+ * @ir: The line record to be filled.
+ *
+ * Only the first LINE_SIZE characters of the line are scanned.
+ * All the strings of the record are kept inside the record itself.
+ */
+void tokenizeLine(const char *line, int len, line_ir *ir)
+{
+	const char *end = line;
+	unsigned int spaces[SPACE_BITS_WORDS]; /* a bit for every whitespace of the line */
+	int length;
+	int pos = 0;
+	int after_keyword = -1; /* the position right after the instruction or directive word */
+	char *out = ir -> text;
+	int keyword_index;
+	int i;
+
+	/* find the end of the line */
+	if (len > LINE_SIZE) {
+		len = LINE_SIZE;
+	}
+	while (end < line + len && *end != '\0' && *end != '\n') {end++; }
+	length = end - line;
+
+	/* classify the whole line once, the words are found by the bits of its whitespaces */
+	scanSpaces(line, length, spaces);
+
+	/* split the line into whitespace separated words */
+	ir -> num_of_words = 0;
+	ir -> has_label = 0;
+	while (1)
+	{
+		int start = findBit(spaces, pos, length, 0); /* skip the whitespaces */
+		if (start == length) {
+			break;
+		}
+		pos = findBit(spaces, start, length, 1); /* the end of the word */
+
+		if (ir -> num_of_words < MAX_LINE_WORDS) {
+			memcpy(out, line + start, pos - start);
+			out[pos - start] = '\0';
+			ir -> words[ir -> num_of_words] = out;
+			out += (pos - start) + 1;
+		}
+
+		/* a first word that ends with ':' defines a label, keep its name without the ':' */
+		if (ir -> num_of_words == 0 && line[pos - 1] == ':') {
+			ir -> has_label = 1;
+			*(out - 2) = '\0';
+		}
+
+		ir -> num_of_words++;
+		if (ir -> num_of_words == ir -> has_label + 1) {
+			after_keyword = pos;
+		}
+	}
+
+	/* get the instruction or directive word */
+	keyword_index = ir -> has_label;
+	ir -> keyword = (ir -> num_of_words > keyword_index) ? ir -> words[keyword_index] : "";
+
+	/* save the text after the instruction or directive word */
+	ir -> args = out;
+	if (after_keyword != -1) {
+		after_keyword = findBit(spaces, after_keyword, length, 0);
+		memcpy(out, line + after_keyword, length - after_keyword);
+		out += length - after_keyword;
+	}
+	*out = '\0';
+
+	/* recognize the kind of the line */
+	ir -> opcode = -1;
+	ir -> num_of_operands = 0;
+	ir -> commas_ok = 1;
+	ir -> length = 0;
+
+	if (ir -> num_of_words == 0) {
+		ir -> kind = LINE_BLANK;
+		return;
+	}
+	if (line[0] == ';') {
+		ir -> kind = LINE_COMMENT;
+		return;
+	}
+
+	/* .data or .string may appear anywhere in the line */
+	for (i = 0; i < ir -> num_of_words && i < MAX_LINE_WORDS; i++) {
+		if (strcmp(ir -> words[i], ".data") == 0) {
+			ir -> kind = LINE_DATA;
+			return;
+		}
+		if (strcmp(ir -> words[i], ".string") == 0) {
+			ir -> kind = LINE_STRING;
+			return;
+		}
+	}
+
+	/* .entry or .extern is either the first or the second word */
+	for (i = 0; i < 2 && i < ir -> num_of_words; i++) {
+		if (strcmp(ir -> words[i], ".entry") == 0) {
+			ir -> kind = LINE_ENTRY;
+			return;
+		}
+	}
+	for (i = 0; i < 2 && i < ir -> num_of_words; i++) {
+		if (strcmp(ir -> words[i], ".extern") == 0) {
+			ir -> kind = LINE_EXTERN;
+			return;
+		}
+	}
+
+	ir -> kind = LINE_INSTRUCTION;
+	ir -> opcode = findOpcode(ir -> keyword);
+	if (ir -> opcode == -1) {
+		return; /* unknown instruction word */
+	}
+
+	/* split the operands and count the machine words: the first word, and one word for every operand,
+	   except for two register operands that share the same word */
+	tokenizeOperands(ir);
+	ir -> length = 1 + ir -> num_of_operands;
+	if (ir -> num_of_operands == 2 &&
+		(ir -> addressing[0] == ADDR_INDIRECT || ir -> addressing[0] == ADDR_REGISTER) &&
+		(ir -> addressing[1] == ADDR_INDIRECT || ir -> addressing[1] == ADDR_REGISTER)) {
+		ir -> length--;
+	}
+}
@@ -0,0 +1,484 @@
+/*
+ * linker.c - This file contains the in-memory linker of the assembler ("--link").
+ * Every file of the invocation that was assembled successfully is kept as a module: its words, the
+ * addresses of its ".entry" labels and the words that use its ".extern" labels. Once all the files are
+ * done, the modules are linked into a single image: the instructions of all the modules first, in the
+ * order of the command line, and then all of their data. The relocatable words of every module are moved
+ * to the new addresses, the entries of all the modules are kept in one hash index, and every extern word
+ * is resolved against it - without writing and parsing again the .ent and .ext files of the modules.
+ */
+
+#include "assembler.h"
+#include "assemble.h"
+
+
+#define LINK_INDEX_MIN_SIZE 64 /* minimal num of buckets in the index of the entries, a power of 2 */
+
+#define ARE_MASK 7 /* the ARE bits of a word */
+#define ARE_RELOCATABLE 2
+
+/* this struct defines an entry of the hash index, the entries of all the modules */
+typedef struct {
+	const char *name; /* NULL for an empty bucket */
+	unsigned int hash;
+	int address; /* the address in the linked image */
+	int module; /* index of the module that defined it */
+} link_bucket;
+
+/* this struct defines the linked image */
+typedef struct {
+	unsigned short *words;
+	int IC; /* num of instruction words, of all the modules */
+	int DC; /* num of data words, of all the modules */
+	link_bucket *index; /* the hash index of the entries */
+	int mask; /* num of buckets in the index minus 1 */
+	int num_of_entries;
+} linked_image;
+
+
+/*
+ * keepSymbol - Adds a symbol to a list of symbols of a module.
+ * @m: The module.
+ * @list: The list (the entries or the externs of the module).
+ * @size: The num of symbols in the list.
+ * @name: The label name.
+ * @address: The address of the symbol.
+ *
+ * Return: 1 on success, 0 on memory error.
+ */
+static int keepSymbol(link_module *m, link_symbol *list, int *size, const char *name, int address)
+{
+	list[*size].name = m -> names.size;
+	list[*size].address = address;
+	(*size)++;
+	return appendText(&m -> names, name, strlen(name) + 1);
+}
+
+
+/*
+ * keepModule - Keeps the output of the file that was just assembled in the current context, for the linker.
+ * @m: The module to be filled.
+ * @file_name: The name of the file, without ".as".
+ *
+ * Must be called after the second stage, before the tables of the file are freed.
+ *
+ * Return: 1 on success, 0 on memory error.
+ */
+int keepModule(link_module *m, char *file_name)
+{
+	int num_of_entries = Ctx -> output_plan.num_of_entries;
+	int i;
+
+	memset(m, 0, sizeof(link_module));
+	m -> file_name = file_name;
+	m -> IC = Ctx -> instruction_image.size;
+	m -> DC = Ctx -> data_image.size;
+
+	m -> words = (unsigned short *) malloc((m -> IC + m -> DC + 1) * sizeof(unsigned short));
+	m -> entries = (link_symbol *) malloc((num_of_entries + 1) * sizeof(link_symbol));
+	m -> externs = (link_symbol *) malloc((Ctx -> extern_uses.size + 1) * sizeof(link_symbol));
+	STAT_COUNT(allocations);
+	if (m -> words == NULL || m -> entries == NULL || m -> externs == NULL) {
+		freeModule(m);
+		return 0; /* memory error */
+	}
+
+	for (i = 0; i < m -> IC; i++) {
+		m -> words[i] = Ctx -> instruction_image.cells[i].MILA;
+	}
+	for (i = 0; i < m -> DC; i++) {
+		m -> words[m -> IC + i] = Ctx -> data_image.cells[i].MILA;
+	}
+
+	for (i = 0; i < num_of_entries; i++) {
+		Lptr p = plannedEntry(i);
+		if (keepSymbol(m, m -> entries, &m -> num_of_entries, getName(p -> name_id), p -> value) == 0) {
+			freeModule(m);
+			return 0;
+		}
+	}
+	for (i = 0; i < Ctx -> extern_uses.size; i++) {
+		extern_use *use = &Ctx -> extern_uses.items[i];
+		if (keepSymbol(m, m -> externs, &m -> num_of_externs, getName(use -> name_id), use -> address) == 0) {
+			freeModule(m);
+			return 0;
+		}
+	}
+
+	m -> kept = 1;
+	return 1;
+}
+
+
+/*
+ * freeModule - Frees everything a module keeps.
+ * @m: The module.
+ */
+void freeModule(link_module *m)
+{
+	free(m -> words);
+	free(m -> entries);
+	free(m -> externs);
+	free(m -> names.text);
+	memset(m, 0, sizeof(link_module));
+}
+
+
+/*
+ * relocate - Moves an address of a module to its address in the linked image.
+ * @m: The module.
+ * @address: The address, as it was assembled (the module loaded alone at FIRST_ADDRESS).
+ *
+ * Return: The address in the linked image.
+ */
+static int relocate(const link_module *m, int address)
+{
+	if (address < FIRST_ADDRESS + m -> IC) {
+		return address - FIRST_ADDRESS + m -> code_address;
+	}
+	return address - FIRST_ADDRESS - m -> IC + m -> data_address;
+}
+
+
+/*
+ * findLinkBucket - Finds the bucket of a name in the index of the entries.
+ * @index: The index.
+ * @mask: The num of buckets minus 1.
+ * @name: The label name.
+ * @hash: The hash value of the name.
+ *
+ * Return: The bucket of the name, or the empty bucket it should be put in.
+ */
+static link_bucket *findLinkBucket(link_bucket *index, int mask, const char *name, unsigned int hash)
+{
+	int i = hash & mask;
+	while (index[i].name != NULL && (index[i].hash != hash || strcmp(index[i].name, name) != 0)) {
+		i = (i + 1) & mask;
+	}
+	return &index[i];
+}
+
+
+/*
+ * linkedAddress - Returns the address of an entry label in the linked image.
+ * @image: The linked image.
+ * @name: The label name.
+ *
+ * Return: The address.
+ */
+static int linkedAddress(const linked_image *image, const char *name)
+{
+	return findLinkBucket(image -> index, image -> mask, name, hashName(name)) -> address;
+}
+
+
+/*
+ * tooManyLinkErrors - Checks if the link has reached the num of errors of "--max-errors".
+ * @name: The name of the linked image, used in the diagnostics.
+ *
+ * The first time the limit is reached it's reported, the rest of the modules are then skipped.
+ *
+ * Return: 1 if the link should be stopped, 0 otherwise.
+ */
+static int tooManyLinkErrors(const char *name)
+{
+	if (MAX_ERRORS == 0 || Ctx -> error_count < MAX_ERRORS) {
+		return 0;
+	}
+	if (Ctx -> errors_capped == 0) {
+		Ctx -> errors_capped = 1;
+		diagPrintf(DIAG_ERRORS_LIMIT, 0, "\nNOTICE: in link of \"%s\", stopped after %d errors (\"--max-errors\"), the rest of the link is skipped.\n", name, MAX_ERRORS);
+	}
+	return 1;
+}
+
+
+/*
+ * writeLinkedText - Writes the linked image as "output/<name>.ob", and its entries as "output/<name>.ent".
+ * @name: The name of the linked image.
+ * @modules: The modules.
+ * @num_of_modules: The num of modules.
+ * @image: The linked image.
+ *
+ * The entries are written in the order of the modules, and of their definition in every module.
+ * Every file is formatted into a single buffer, the same way the object and entry files of a file are, and written at once.
+ *
+ * Return: 1 on success, 0 when a file can't be created, 2 on memory error.
+ */
+static int writeLinkedText(const char *name, const link_module *modules, int num_of_modules, const linked_image *image)
+{
+	char file_name[256 + 12];
+	int total_cells = image -> IC + image -> DC;
+	text_buffer entries = {NULL, 0, 0};
+	output_file out;
+	char *buffer;
+	char *p;
+	int i, j;
+
+	/* the header, and a line of "address word" for every cell: at most 10 + 1 + 5 + 1 characters */
+	buffer = (char *) malloc(2 * 10 + 2 + total_cells * 17);
+	STAT_COUNT(allocations);
+	if (buffer == NULL) {
+		return 2; /* memory error */
+	}
+	p = buffer;
+	p += formatDecimal(p, image -> IC, 1);
+	*p++ = ' ';
+	p += formatDecimal(p, image -> DC, 1);
+	*p++ = '\n';
+	for (i = 0; i < total_cells; i++) {
+		p += formatDecimal(p, i + FIRST_ADDRESS, 4);
+		*p++ = ' ';
+		formatOctalWord(p, image -> words[i]);
+		p += 5;
+		*p++ = '\n';
+	}
+
+	sprintf(file_name, "output/%s.ob", name);
+	if (openOutput(&out, file_name, "w") == NULL) {
+		diagPrintf(DIAG_OUTPUT_FILE, 0, "ERROR: Unable to create object file: \"%s\".\n", file_name);
+		free(buffer);
+		return 0;
+	}
+	fwrite(buffer, 1, p - buffer, out.fp);
+	free(buffer);
+	if (closeOutput(&out) == 0) {
+		diagPrintf(DIAG_OUTPUT_FILE, 0, "ERROR: Unable to create object file: \"%s\".\n", file_name);
+		return 0;
+	}
+
+	if (image -> num_of_entries == 0) {
+		return 1;
+	}
+	for (i = 0; i < num_of_modules; i++) {
+		for (j = 0; j < modules[i].num_of_entries; j++) {
+			const char *entry = modules[i].names.text + modules[i].entries[j].name;
+			if (writeLabelLine(&entries, entry, linkedAddress(image, entry), 1) == 0) {
+				free(entries.text);
+				return 2; /* memory error */
+			}
+		}
+	}
+
+	sprintf(file_name, "output/%s.ent", name);
+	if (openOutput(&out, file_name, "w") == NULL) {
+		diagPrintf(DIAG_OUTPUT_FILE, 0, "ERROR: Unable to create entry file: \"%s\".\n", file_name);
+		free(entries.text);
+		return 0;
+	}
+	fwrite(entries.text, 1, entries.size, out.fp);
+	free(entries.text);
+	if (closeOutput(&out) == 0) {
+		diagPrintf(DIAG_OUTPUT_FILE, 0, "ERROR: Unable to create entry file: \"%s\".\n", file_name);
+		return 0;
+	}
+	return 1;
+}
+
+
+/*
+ * writeLinkedBinary - Writes the linked image as a binary object file "output/<name>.bin" (without externs).
+ * @name: The name of the linked image.
+ * @modules: The modules.
+ * @num_of_modules: The num of modules.
+ * @image: The linked image.
+ *
+ * Return: 1 on success, 0 when the file can't be created, 2 on memory error.
+ */
+static int writeLinkedBinary(const char *name, const link_module *modules, int num_of_modules, const linked_image *image)
+{
+	char file_name[256 + 12];
+	int total_cells = image -> IC + image -> DC;
+	int symbols_offset = (ASM_BIN_HEADER_SIZE + total_cells * 2 + 3) & ~3; /* aligned to 4 bytes */
+	int length = symbols_offset + image -> num_of_entries * ASM_BIN_SYMBOL_SIZE;
+	unsigned char *buffer;
+	unsigned char *out;
+	output_file bin;
+	int i, j;
+
+	buffer = (unsigned char *) calloc(length, 1);
+	if (buffer == NULL) {
+		return 2; /* memory error */
+	}
+
+	memcpy(buffer, ASM_BIN_MAGIC, 4);
+	putWord32(buffer + 4, ASM_BIN_VERSION);
+	putWord32(buffer + 8, image -> IC);
+	putWord32(buffer + 12, image -> DC);
+	putWord32(buffer + 16, FIRST_ADDRESS);
+	putWord32(buffer + 20, image -> num_of_entries);
+	putWord32(buffer + 24, 0); /* all the externs are resolved */
+	putWord32(buffer + 28, symbols_offset);
+
+	out = buffer + ASM_BIN_HEADER_SIZE;
+	for (i = 0; i < total_cells; i++) {
+		unsigned int word = image -> words[i] & 0x7fff;
+		*out++ = (unsigned char) (word & 0xff);
+		*out++ = (unsigned char) (word >> 8);
+	}
+	out = buffer + symbols_offset;
+	for (i = 0; i < num_of_modules; i++) {
+		for (j = 0; j < modules[i].num_of_entries; j++) {
+			const char *entry = modules[i].names.text + modules[i].entries[j].name;
+			putSymbol(out, entry, linkedAddress(image, entry));
+			out += ASM_BIN_SYMBOL_SIZE;
+		}
+	}
+
+	sprintf(file_name, "output/%s.bin", name);
+	if (openOutput(&bin, file_name, "wb") == NULL) {
+		diagPrintf(DIAG_OUTPUT_FILE, 0, "ERROR: Unable to create binary object file: \"%s\".\n", file_name);
+		free(buffer);
+		return 0;
+	}
+	fwrite(buffer, 1, length, bin.fp);
+	free(buffer);
+	if (closeOutput(&bin) == 0) {
+		diagPrintf(DIAG_OUTPUT_FILE, 0, "ERROR: Unable to create binary object file: \"%s\".\n", file_name);
+		return 0;
+	}
+	return 1;
+}
+
+
+/*
+ * linkModules - Links the kept modules into a single image, and writes it to the output directory.
+ * @modules: The modules, the ones that weren't kept are skipped.
+ * @num_of_modules: The num of modules.
+ * @name: The name of the linked image (its output files are "output/<name>.ob" and ".ent", or ".bin").
+ *
+ * The instructions of all the modules come first, in order, and then their data. An entry that is defined
+ * by two modules and an extern that isn't an entry of any module are errors, and so is a linked image that
+ * doesn't fit in memory, or an address that doesn't fit in an operand word. The link is stopped after
+ * the num of errors of "--max-errors".
+ * NOTICE: the diagnostics are kept in the current context, which must be set.
+ *
+ * Return: 1 on success, 0 on a link error, 2 on memory error.
+ */
+int linkModules(link_module *modules, int num_of_modules, const char *name)
+{
+	linked_image image;
+	int size = LINK_INDEX_MIN_SIZE;
+	int errors = 0;
+	int stopped = 0; /* 1 - the link was stopped by "--max-errors" */
+	int result;
+	int i, j;
+
+	if (strlen(name) >= 256) {
+		diagPrintf(DIAG_LINK_NAME, 0, "\nERROR: in link of \"%s\", the name is too long.\n", name);
+		return 0;
+	}
+
+	/* --(lay out the modules)-- */
+	memset(&image, 0, sizeof(linked_image));
+	for (i = 0; i < num_of_modules; i++) {
+		if (modules[i].kept == 1) {
+			modules[i].code_address = FIRST_ADDRESS + image.IC;
+			image.IC += modules[i].IC;
+			image.DC += modules[i].DC;
+			image.num_of_entries += modules[i].num_of_entries;
+		}
+	}
+	for (i = 0, j = FIRST_ADDRESS + image.IC; i < num_of_modules; i++) {
+		if (modules[i].kept == 1) {
+			modules[i].data_address = j;
+			j += modules[i].DC;
+		}
+	}
+	if (FIRST_ADDRESS + image.IC + image.DC > MEMORY_WORDS) {
+		diagPrintf(DIAG_MEMORY_LIMIT, 0, "\nERROR: in link of \"%s\", the linked image surpasses the memory limit of %d.\n", name, MEMORY_WORDS);
+		return 0;
+	}
+
+	while (size < 2 * image.num_of_entries) {
+		size *= 2;
+	}
+	image.mask = size - 1;
+	image.index = (link_bucket *) calloc(size, sizeof(link_bucket));
+	image.words = (unsigned short *) malloc((image.IC + image.DC + 1) * sizeof(unsigned short));
+	if (image.index == NULL || image.words == NULL) {
+		free(image.index);
+		free(image.words);
+		return 2; /* memory error */
+	}
+
+	/* --(index the entries of all the modules)-- */
+	for (i = 0; i < num_of_modules && stopped == 0; i++) {
+		link_module *m = &modules[i];
+		for (j = 0; j < m -> num_of_entries && stopped == 0; j++) {
+			const char *entry = m -> names.text + m -> entries[j].name;
+			unsigned int hash = hashName(entry);
+			link_bucket *b = findLinkBucket(image.index, image.mask, entry, hash);
+
+			if (b -> name != NULL) {
+				diagPrintf(DIAG_LINK_ENTRY, 0, "\nERROR: in link of \"%s\", the entry label \"%s\" is defined in both \"%s\" and \"%s\".\n", name, entry, modules[b -> module].file_name, m -> file_name);
+				errors++;
+				stopped = tooManyLinkErrors(name);
+				continue;
+			}
+			b -> name = entry;
+			b -> hash = hash;
+			b -> address = relocate(m, m -> entries[j].address);
+			b -> module = i;
+		}
+	}
+
+	/* --(move the words of every module to their place, and relocate its label words)-- */
+	for (i = 0; i < num_of_modules && stopped == 0; i++) {
+		link_module *m = &modules[i];
+		unsigned short *code = image.words + m -> code_address - FIRST_ADDRESS;
+
+		if (m -> kept == 0) {
+			continue;
+		}
+		for (j = 0; j < m -> IC && stopped == 0; j++) {
+			unsigned short word = m -> words[j];
+			if ((word & ARE_MASK) == ARE_RELOCATABLE) {
+				int address = relocate(m, word >> 3);
+				if (address > MAX_LABEL_ADDRESS) {
+					diagPrintf(DIAG_LABEL_ADDRESS, 0, "\nERROR: in link of \"%s\", the address %d of a label of \"%s\" doesn't fit in an operand word (at most %d).\n", name, address, m -> file_name, MAX_LABEL_ADDRESS);
+					errors++;
+					stopped = tooManyLinkErrors(name);
+				}
+				word = (unsigned short) ((address << 3) | ARE_RELOCATABLE);
+			}
+			code[j] = word;
+		}
+		memcpy(image.words + m -> data_address - FIRST_ADDRESS, m -> words + m -> IC, m -> DC * sizeof(unsigned short));
+
+		/* --(resolve the externs of the module against the entries)-- */
+		for (j = 0; j < m -> num_of_externs && stopped == 0; j++) {
+			const char *label = m -> names.text + m -> externs[j].name;
+			link_bucket *b = findLinkBucket(image.index, image.mask, label, hashName(label));
+
+			if (b -> name == NULL) {
+				diagPrintf(DIAG_LINK_UNRESOLVED, 0, "\nERROR: in link of \"%s\", the external label \"%s\" of \"%s\" isn't an entry of any file.\n", name, label, m -> file_name);
+				errors++;
+				stopped = tooManyLinkErrors(name);
+			}
+			else if (b -> address > MAX_LABEL_ADDRESS) {
+				diagPrintf(DIAG_LABEL_ADDRESS, 0, "\nERROR: in link of \"%s\", the address %d of label \"%s\" doesn't fit in an operand word (at most %d).\n", name, b -> address, label, MAX_LABEL_ADDRESS);
+				errors++;
+				stopped = tooManyLinkErrors(name);
+			}
+			else {
+				code[m -> externs[j].address] = (unsigned short) ((b -> address << 3) | ARE_RELOCATABLE);
+			}
+		}
+	}
+
+	/* --(write the linked image)-- */
+	if (errors > 0) {
+		result = 0;
+	}
+	else if (OUTPUT_FORMAT == FORMAT_BIN) {
+		result = writeLinkedBinary(name, modules, num_of_modules, &image);
+	}
+	else {
+		result = writeLinkedText(name, modules, num_of_modules, &image);
+	}
+
+	free(image.index);
+	free(image.words);
+	return result;
+}
@@ -0,0 +1,108 @@
+/*
+ * memory_image.c - This file contains the memory image of the assembler.
+ * The memory has MEMORY_WORDS words ("--mem-words"), but only the addresses a program is loaded at are
+ * ever used, so the image is kept in pages of MEMORY_PAGE_WORDS words that are allocated on the first
+ * store into them. A small program takes a page or two, however big the memory is.
+ * The pages belong to the context, and are reused by the next files assembled in it.
+ */
+
+#include "assembler.h"
+
+
+int MEMORY_WORDS = MEMORY_SIZE;
+
+
+/*
+ * memoryPage - Returns the page of an address, allocating it when it was never touched.
+ * @address: The address.
+ *
+ * Return: The page, NULL on memory error.
+ */
+static mila *memoryPage(int address)
+{
+	memory_image *m = &Ctx -> memory_image;
+	int page = address >> MEMORY_PAGE_SHIFT;
+
+	/* grow the table of pages up to the page of the address */
+	if (page >= m -> num_of_pages) {
+		int num_of_pages = page + 1;
+		mila **pages = (mila **) realloc(m -> pages, num_of_pages * sizeof(mila *));
+		TABLE_GROWTH();
+		if (pages == NULL) {
+			return NULL;
+		}
+		memset(pages + m -> num_of_pages, 0, (num_of_pages - m -> num_of_pages) * sizeof(mila *));
+		m -> pages = pages;
+		m -> num_of_pages = num_of_pages;
+	}
+
+	if (m -> pages[page] == NULL) {
+		m -> pages[page] = (mila *) calloc(MEMORY_PAGE_WORDS, sizeof(mila));
+		TABLE_GROWTH();
+	}
+	return m -> pages[page];
+}
+
+
+/*
+ * storeWords - Stores a run of words in the memory image.
+ * @address: The address of the first word.
+ * @cells: The words.
+ * @count: The num of words.
+ *
+ * Return: 1 on success, 0 on memory error.
+ */
+int storeWords(int address, const mila *cells, int count)
+{
+	while (count > 0) {
+		int offset = address & (MEMORY_PAGE_WORDS - 1);
+		int length = MEMORY_PAGE_WORDS - offset; /* the rest of the page */
+		mila *page = memoryPage(address);
+
+		if (page == NULL) {
+			return 0; /* memory error */
+		}
+		if (length > count) {
+			length = count;
+		}
+		memcpy(page + offset, cells, length * sizeof(mila));
+		address += length;
+		cells += length;
+		count -= length;
+	}
+	return 1;
+}
+
+
+/*
+ * memoryWord - Returns a word of the memory image.
+ * @address: The address of the word.
+ *
+ * Return: The word, 0 when it was never stored.
+ */
+unsigned short memoryWord(int address)
+{
+	memory_image *m = &Ctx -> memory_image;
+	int page = address >> MEMORY_PAGE_SHIFT;
+
+	if (page >= m -> num_of_pages || m -> pages[page] == NULL) {
+		return 0;
+	}
+	return m -> pages[page][address & (MEMORY_PAGE_WORDS - 1)].MILA;
+}
+
+
+/*
+ * freeMemoryImage - Frees all the pages of a memory image.
+ * @m: The memory image.
+ */
+void freeMemoryImage(memory_image *m)
+{
+	int i;
+	for (i = 0; i < m -> num_of_pages; i++) {
+		free(m -> pages[i]);
+	}
+	free(m -> pages);
+	m -> pages = NULL;
+	m -> num_of_pages = 0;
+}
@@ -0,0 +1,65 @@
+/*
+ * opcode_table.c - This file contains the opcode table of the assembler.
+ * Everything the assembler knows about an instruction (its name, its opcode, its num of operands and
+ * the addressing modes its source and target operands may use) is kept in a single constant table,
+ * indexed by the opcode. An instruction word is found by a perfect hash of its first three characters,
+ * so recognizing an instruction takes a single string compare, and checking an addressing mode is a bit test.
+ */
+
+#include "assembler.h"
+
+
+/* the addressing modes of operands as masks */
+#define ALL_MODES (ADDR_MASK(ADDR_IMMEDIATE) | ADDR_MASK(ADDR_DIRECT) | ADDR_MASK(ADDR_INDIRECT) | ADDR_MASK(ADDR_REGISTER))
+#define NO_IMMEDIATE (ADDR_MASK(ADDR_DIRECT) | ADDR_MASK(ADDR_INDIRECT) | ADDR_MASK(ADDR_REGISTER))
+#define JUMP_MODES (ADDR_MASK(ADDR_DIRECT) | ADDR_MASK(ADDR_INDIRECT))
+
+/* the instructions, sorted by opcode */
+const opcode_info OPCODES[NUM_OF_OPCODES] = {
+	{"mov", 2, ALL_MODES, NO_IMMEDIATE},
+	{"cmp", 2, ALL_MODES, ALL_MODES},
+	{"add", 2, ALL_MODES, NO_IMMEDIATE},
+	{"sub", 2, ALL_MODES, NO_IMMEDIATE},
+	{"lea", 2, ADDR_MASK(ADDR_DIRECT), NO_IMMEDIATE},
+	{"clr", 1, 0, NO_IMMEDIATE},
+	{"not", 1, 0, NO_IMMEDIATE},
+	{"inc", 1, 0, NO_IMMEDIATE},
+	{"dec", 1, 0, NO_IMMEDIATE},
+	{"jmp", 1, 0, JUMP_MODES},
+	{"bne", 1, 0, JUMP_MODES},
+	{"red", 1, 0, NO_IMMEDIATE},
+	{"prn", 1, 0, ALL_MODES},
+	{"jsr", 1, 0, JUMP_MODES},
+	{"rts", 0, 0, 0},
+	{"stop", 0, 0, 0}
+};
+
+/* the perfect hash of the instruction words: (word[0] + word[1] + 10 * word[2]) % 32 -> opcode, -1 for an empty slot */
+#define OPCODE_HASH(word) (((unsigned char) (word)[0] + (unsigned char) (word)[1] + 10 * (unsigned char) (word)[2]) & 31)
+
+static const signed char opcode_slots[32] = {
+	-1, -1, 10, 5, 14, 6, -1, 8, -1, -1, -1, -1, -1, 2, 12, -1,
+	1, 13, -1, -1, -1, 7, -1, 9, 0, -1, -1, 4, 3, 15, -1, 11
+};
+
+
+/*
+ * findOpcode - Returns the opcode of an instruction word.
+ * @word: The word to be checked.
+ *
+ * Return: The opcode (0-15), -1 if the word isn't an instruction.
+ */
+int findOpcode(const char *word)
+{
+	int opcode;
+
+	/* every instruction word has at least three characters */
+	if (word[0] == '\0' || word[1] == '\0') {
+		return -1;
+	}
+	opcode = opcode_slots[OPCODE_HASH(word)];
+	if (opcode == -1 || strcmp(word, OPCODES[opcode].name) != 0) {
+		return -1;
+	}
+	return opcode;
+}
@@ -0,0 +1,169 @@
+/*
+ * output_plan.c - This file contains the output plan of a file, and the writing of the output files.
+ * The plan is gathered while the file is assembled: the ".entry" labels are added when their status is
+ * changed, and the ".external" labels are counted when they're defined, so the output files are written
+ * straight from the plan (and the images), without going over the symbol table again.
+ * Every output file is written to "<name>.tmp" and renamed once it's complete, so an existing output file
+ * is never left half written.
+ */
+
+#include "assembler.h"
+
+
+/*
+ * planEntry - Adds a label to the entries of the output plan.
+ * @label: The label record, it's just being marked as ".entry".
+ *
+ * Return: 1 on success, 0 on memory error.
+ */
+int planEntry(Lptr label)
+{
+	output_plan *plan = &Ctx -> output_plan;
+
+	if (plan -> num_of_entries == plan -> entries_capacity) {
+		int new_capacity = (plan -> entries_capacity == 0) ? OUTPUT_PLAN_INIT_SIZE : plan -> entries_capacity * 2;
+		int *new_entries = (int *) realloc(plan -> entries, new_capacity * sizeof(int));
+		TABLE_GROWTH();
+		if (new_entries == NULL) {
+			return 0; /* memory error */
+		}
+		plan -> entries = new_entries;
+		plan -> entries_capacity = new_capacity;
+	}
+
+	plan -> entries[plan -> num_of_entries++] = (int) (label - Ctx -> symbols.labels);
+	return 1;
+}
+
+
+/*
+ * plannedEntry - Returns an entry of the output plan.
+ * @i: The index of the entry in the plan.
+ *
+ * Return: The label record of the entry.
+ */
+Lptr plannedEntry(int i)
+{
+	return &Ctx -> symbols.labels[Ctx -> output_plan.entries[i]];
+}
+
+
+/*
+ * compareEntries - Compares two entries by their index in the label table, the order of their definition (used by qsort).
+ */
+static int compareEntries(const void *a, const void *b)
+{
+	return *(const int *) a - *(const int *) b;
+}
+
+
+/*
+ * compareExternUses - Compares two extern uses by their word address (used by qsort).
+ */
+static int compareExternUses(const void *a, const void *b)
+{
+	return ((const extern_use *) a) -> address - ((const extern_use *) b) -> address;
+}
+
+
+/*
+ * finishOutputPlan - Puts the plan in the order of the output files, once the second stage is done.
+ * The entries are sorted by their definition (the order of the symbol table), and the extern uses
+ * by their word address.
+ */
+void finishOutputPlan()
+{
+	output_plan *plan = &Ctx -> output_plan;
+
+	if (plan -> num_of_entries > 1) {
+		qsort(plan -> entries, plan -> num_of_entries, sizeof(int), compareEntries);
+	}
+	if (Ctx -> extern_uses.size > 1) {
+		qsort(Ctx -> extern_uses.items, Ctx -> extern_uses.size, sizeof(extern_use), compareExternUses);
+	}
+}
+
+
+/*
+ * freeOutputPlan - Frees the memory allocated for the output plan.
+ */
+void freeOutputPlan()
+{
+	free(Ctx -> output_plan.entries);
+	memset(&Ctx -> output_plan, 0, sizeof(output_plan));
+}
+
+
+/*
+ * openOutput - Opens an output file, the text is written to a temporary file until it's closed.
+ * @out: The output file to be filled.
+ * @name: The name of the output file.
+ * @mode: The mode of fopen ("w" or "wb").
+ *
+ * Return: The file pointer to the temporary file, NULL if it can't be created.
+ */
+FILE *openOutput(output_file *out, const char *name, const char *mode)
+{
+	int length = strlen(name);
+
+	out -> fp = NULL;
+	out -> name = (char *) malloc(length + 1);
+	out -> temp_name = (char *) malloc(length + 5);
+	if (out -> name == NULL || out -> temp_name == NULL) {
+		free(out -> name);
+		free(out -> temp_name);
+		out -> name = out -> temp_name = NULL;
+		return NULL;
+	}
+	strcpy(out -> name, name);
+	sprintf(out -> temp_name, "%s.tmp", name);
+
+	out -> fp = fopen(out -> temp_name, mode);
+	if (out -> fp == NULL) {
+		discardOutput(out);
+	}
+	return out -> fp;
+}
+
+
+/*
+ * closeOutput - Closes an output file, and renames the temporary file to the output file.
+ * @out: The output file.
+ *
+ * Return: 1 on success, 0 if the file couldn't be written (the temporary file is removed).
+ */
+int closeOutput(output_file *out)
+{
+	int written = (ferror(out -> fp) == 0);
+
+	written = (fclose(out -> fp) == 0) && written;
+	out -> fp = NULL;
+	if (written == 0 || rename(out -> temp_name, out -> name) != 0) {
+		discardOutput(out);
+		return 0;
+	}
+
+	free(out -> name);
+	free(out -> temp_name);
+	out -> name = out -> temp_name = NULL;
+	return 1;
+}
+
+
+/*
+ * discardOutput - Closes an output file without writing it, the output file itself isn't touched.
+ * @out: The output file.
+ */
+void discardOutput(output_file *out)
+{
+	if (out -> fp != NULL) {
+		fclose(out -> fp);
+		out -> fp = NULL;
+	}
+	if (out -> temp_name != NULL) {
+		remove(out -> temp_name);
+	}
+	free(out -> name);
+	free(out -> temp_name);
+	out -> name = out -> temp_name = NULL;
+}
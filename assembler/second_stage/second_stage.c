@@ -1,7 +1,7 @@
 /*
  * second_stage.c - Second stage function for the assembler project
- * This file contains the second stage function which processes a given input file (.am),
- * handling the encoding of labels and instructions that were not fully processed in the first stage.
+ * This file contains the second stage function which goes over the fixup table recorded on the first stage,
+ * handling the encoding of labels and the .entry directives that could not be processed in the first stage.
  * It ensures all labels are correctly referenced and encoded in the instruction memory image.
  */
 
@@ -14,10 +14,10 @@
  * second_stage - Handles the second stage of the assembler process.
  * @file_name: Name of the input file to be processed.
  * 
- * This function processes the .am file line by line, handling the encoding of labels 
- * and instructions that were not fully processed in the first stage. It ensures all labels 
- * are correctly referenced and encoded in the instruction memory image. Additionally, it creates
- * the final output files necessary for the assembler.
+ * This function goes over the fixup table in source order, patching the operand words
+ * that call labels which were not known on the first stage, and changing the status of the
+ * .entry labels. The .am file is not read again. The memory image is then complete,
+ * and the output files are created by the caller ("createOutput").
  * 
  * Return: 0 - regular error
  *         1 - success
@@ -26,136 +26,41 @@
 int second_stage(char *file_name)
 {
 	int err_count = 0;
-	int IC = 0; /* instruction counter */
-	int L = 0; /* words counter */
-    int line_num = 0;
-    
-	/* open .am file */
-	char filename[256];
-	sprintf(filename, "pre_processing/%s.am", file_name);
-	
-	FILE *fp = fopen(filename, "r"); 
-	if (fp == NULL) {
-		printf("ERROR: Unable to open file: \"%s.am\".\n", file_name);
-		return 0;
-	}
+    int err_line_num = 0; /* line of the last error, only one error is reported per line */
+    int i;
 
-	/* Reading line after line */
-    char line[LINE_SIZE]; 
-	while (fgets(line, sizeof(line), fp)) 
+	for (i = 0; i < Ctx -> fixup_table.size; i++) 
 	{
-        int LABEL_FLAG = 0;
-        char *word_check;
-		int encodeErr;
+        fixup *f = &Ctx -> fixup_table.items[i];
+        int encodeErr;
 
-        /* Reading the first word in a line. */
-		char *word = get_first_word(line); 
-		if (word == NULL || strcmp(word, "") == 0 || *word == '\n') {
-            continue; /* Skip blank lines */
-        }	
-	
-		line_num++; /* First line is 1 */
-
-		/* --(PRE-ERROR Checking)-- */
-		if (line[0] == ';') { /* ignore comments*/
-			*line = '\0';
-			continue;
-		}
-	
-        /* START THE SECOND STAGE: */
-        
-        /* check if a label is defined and add an error message if there's ".entry" defined later */
-        word[strlen(word)-1] = '\0';
-        
-        if (isAlreadyLabel(word) == 1 || isLabel(line, file_name, line_num) == 3) {
-            
-            /* check .entry and show error message */
-            char *possible_entryORextern = get_second_word(line);
-            /* check .extern or .entry and show error message */
-            if (strcmp(possible_entryORextern, ".extern") == 0 || strcmp(possible_entryORextern, ".entry") == 0) {
-                printf("\nNOTICE: in file \"%s\", line %d, the (possible) label that's defined as a first word will not be considered as label in the label table.\n", file_name, line_num);
-            }
-            LABEL_FLAG = 1; /* label exists in this line */
-        }
-        
-        /* get the instruction-type word */ 
-        if (LABEL_FLAG == 1) {
-            word_check = get_second_word(line);
-            
-        }
-        else {
-            word_check = get_first_word(line);
+        if (f -> line_num == err_line_num) {
+            continue; /* this line was already reported */
         }
-        
-        if (strcmp(word_check, ".data") == 0 || strcmp(word_check, ".string") == 0 || strcmp(word_check, ".extern") == 0) {
-            continue; /* skip line when it's ".data", ".string" or ".extern" */
-        }
-
-        /* check if it's ".entry" instruction */
-        if (strcmp(word_check, ".entry") == 0) {
-
-            /* get label word */
-            char *label_word = (LABEL_FLAG == 1) ? get_third_word(line) : get_second_word(line);
-
-            /* change entry label status */
-            int entryErr = addEntry(file_name, line_num, label_word);
-            if (entryErr == 0) {
-                err_count++;
-                continue; /* regular error */
-            }
-            else if (entryErr == 2) {
-                return 2; /* memory error */
-            }
-            
-            /* check for a second operand */
-            if (check4OperandEntry(file_name, line_num, line, LABEL_FLAG) == 1) {
-                err_count++;
-                continue; /* regular error */
-            }
-
-            continue;
+        if (tooManyErrors(file_name)) {
+            err_count++;
+            break; /* the rest of the file is skipped ("--max-errors") */
         }
 
-        /* encode the first/second operands to the instruction-memory-image */
-        L = encodeErr = encodeMissingOperand(file_name, line_num, line, LABEL_FLAG, IC);
-        
-        if (encodeErr == -2) {
+        /* patch the operand word or change the entry label status */
+        encodeErr = encodeFixup(file_name, f);
+        if (encodeErr == 2) {
             return 2; /* memory error */
         }
-        else if (encodeErr == -1) {
+        else if (encodeErr == 0) {
             err_count++;
+            err_line_num = f -> line_num;
             continue; /* regular error */
         }
-        
-        IC = IC + L; 
-        
-		/* in case there are two registers on the same line, decrease IC as they will be encoded both in the same "mila" */
-		if (isAddressType2Or3(line, file_name, line_num) == 1) {
-			IC--;
-		}
     }
 
-    /* at this point we read all the lines */
+    /* at this point we went over all the fixups */
 
     if (err_count > 0) {
         return 0;
     }
 
-    /* --(run the final stage of the assembler)--  */ 
-	if (createOutput(file_name, line_num, fp) == 0) {	
-        return 2; /* memory error */
-	}	
-
-	fclose(fp);
-	
-
+    /* put the entries and the extern uses in the order of the output files */
+    finishOutputPlan();
 	return 1;
 } 
-
-
-
-
-
-
-
-
@@ -1,6 +1,6 @@
 /*
  * second_stage_func.c - This file handles the second stage of the assembler process.
- * It includes functions for encoding labels in the instruction memory, handling entry directives, 
+ * It includes functions for completing the fixup table records (encoding labels in the instruction memory and handling entry directives), 
  * and generating the output files. The file uses linked lists to manage the label, data, and instruction memory images,
  * ensuring proper encoding and output formatting.
  */
@@ -8,26 +8,32 @@
 #include "../../pre_processing/macros_table.h" 
 #include "../assembler.h"
 #include "../excess_macro_list.h"
+#include "../assemble.h"
+
+
+int OUTPUT_FORMAT = FORMAT_TEXT; /* the format of the output files, set by "--format" */
+int OUTPUT_FILES = 1; /* turned off by "--link-only" */
+int OUTPUT_STREAM = 0; /* turned on by "-" */
 
 
 /*
  * addEntry - Encodes the label within the .entry instruction to the label table.
  * @file_name: The name of the file being processed.
  * @line_num: The current line number being processed.
- * @label_word: The label to be encoded.
+ * @label: The label record of the label word, NULL if no such label was defined.
  * 
  * Return: 1 on success, 0 on regular error, 2 on memory error.
  */
-int addEntry(char *file_name, int line_num, char *label_word)
+int addEntry(char *file_name, int line_num, Lptr label)
 {
     /* check if the label was already added in the first stage*/
-    if (isAlreadyLabel(label_word) == 0) {
-        printf("\nERROR: unkown label word after \".entry\" instruction.\n");
+    if (label == NULL) {
+        diagPrintf(DIAG_LABEL_UNKNOWN, line_num, "\nERROR: unkown label word after \".entry\" instruction.\n");
         return 0;
     }
 
     /* change label status to ".entry" */
-    if (changeEntryStatus(file_name, line_num, label_word) == 0) {
+    if (changeEntryStatus(file_name, line_num, label) == 0) {
         return 2;
     }
 
@@ -36,402 +42,287 @@ int addEntry(char *file_name, int line_num, char *label_word)
 
 
 /*
- * changeEntryStatus - Changes the label status to ".entry".
+ * changeEntryStatus - Marks the label as ".entry" (exported), its kind is kept.
  * @file_name: The name of the file being processed.
  * @line_num: The current line number being processed.
- * @label_word: The label whose status is to be changed.
+ * @label: The label record (from the symbol table) whose status is to be changed.
  * 
  * Return: 1 on success, 0 on memory error.
  */
-int changeEntryStatus(char *file_name, int line_num, char *label_word)
+int changeEntryStatus(char *file_name, int line_num, Lptr label)
 {
-	/* traversing the linked list */
-    Lptr p = Labelhptr;
-    while (p) {	
-        if (strcmp(label_word, p -> label_name) == 0) {
-
-            /* label was found */
-            free(p -> type); /* reset current status */
-
-            /* create the new type cell */
-            p -> type = (char *) malloc(strlen(".entry") + 1);
-                if ((p -> type) == NULL) {
-                printf("\nERROR: in file %s, line %d, unable to allocate memory for label \"%s\".\n", file_name, line_num, label_word);
-                free(p -> label_name);        
-                free(p); /* Clean up allocated memory */
-                return 0;
-            }
-
-            /* add type .entry to label status */
-            strcpy(p -> type, ".entry");
-            return 1; /* success */
-        }
-        p = p->next;
-    }  
-}
-
-
-/*
- * get_third_word - Returns the third word in the given line.
- * @line: The line to be processed.
- * 
- * Return: The third word in the line.
- */
-char *get_third_word(char *line)
-{
-    size_t length;
-    static char third_word[LINE_SIZE];
-
-    if (findNumOfWords(line) < 3) {
-        return ""; /* no third word */
+    /* add the label to the entries of the output plan, once */
+    if ((label -> flags & LABEL_ENTRY) == 0 && planEntry(label) == 0) {
+        diagPrintf(DIAG_NO_MEMORY, line_num, "\nERROR: in file %s, line %d, unable to allocate memory for label \"%s\".\n", file_name, line_num, getName(label -> name_id));
+        return 0;
     }
 
-    /* Skip leading whitespace */
-    line = skipFirstWord(line);
-    line = skipFirstWord(line); /* start of the 3rd word*/  
-
-    /* Find the end of the first word */
-    const char* end = line;
-    while (*end && !isspace(*end)) {
-        end++;
-    }
-    
-    /* Calculate length of the first word */
-    length = end - line;
-    
-	/* Create a static buffer to hold the first word */
-	if (length >= sizeof(third_word)) {
-        printf("Word is too long to fit in the buffer\n");
-        return NULL;
+    /* an external label that's declared as an entry isn't external anymore (its value stays 0) */
+    if (label -> kind == LABEL_EXTERNAL) {
+        label -> kind = LABEL_CODE;
+        Ctx -> output_plan.num_of_externs--;
     }
-    
-    /* Copy the first word */
-    strncpy(third_word, line, length);
-    third_word[length] = '\0';  /* Null-terminate the string */
 
-    return third_word;
+    label -> flags |= LABEL_ENTRY;
+    return 1; /* success */
 }
 
 
 /*
- * get_fourth_word - Returns the fourth word in the given line.
- * @line: The line to be processed.
+ * encodeFixup - Completes a single record of the fixup table.
+ * @file_name: The name of the file being processed.
+ * @f: The fixup record.
+ * 
+ * An operand record is patched with the address of its label (or as an external label),
+ * an entry record changes the status of its label to ".entry".
  * 
- * Return: The fourth word in the line.
+ * Return: 1 on success, 0 on regular error, 2 on memory error.
  */
-char *get_fourth_word(char *line)
+int encodeFixup(char *file_name, fixup *f)
 {
-    const char* end;
-    size_t length;
-    static char fourth_word[LINE_SIZE]; 
-    
-    if (findNumOfWords(line) < 4) {
-        return ""; /* no fourth word */
-    }
-    /* Skip leading whitespace */
-    line = skipFirstWord(line);
-    line = skipFirstWord(line);
-    line = skipFirstWord(line); /* start of the 4rd word*/
-
-    /* Find the end of the first word */
-    end = line;
-    while (*end && !isspace(*end)) {
-        end++;
-    }
-    
-    /* Calculate length of the first word */
-    length = end - line;
-    
-	/* Create a static buffer to hold the first word */ 
-	if (length >= sizeof(fourth_word)) {
-        printf("Word is too long to fit in the buffer\n");
-        return NULL;
-    }
-    
-    /* Copy the first word */
-    strncpy(fourth_word, line, length);
-    fourth_word[length] = '\0';  /* Null-terminate the string */
+    char *operandPlace[] = {"", "first ", "second "};
+    Lptr label = getLabelById(f -> name_id);
+    int encodeErr;
 
-    return fourth_word;
-}
+    if (f -> kind != FIXUP_OPERAND) {
 
+        /* change entry label status */
+        int entryErr = addEntry(file_name, f -> line_num, label);
+        if (entryErr != 1) {
+            return entryErr;
+        }
 
-/* given a line, this function checks whether one of its operands is a label that wasn't encoded in the first-stage,
- * then, the function encodes the specific operand as a mila cell in the correct place. it returns:
- (L) - the value which L needs to be incremented by
- (-1) - regular error
- (-2) - memory error */
-int encodeMissingOperand(char *file_name, int line_num, char *line, int LABEL_FLAG, int IC)
-{
-    
-    int L = 0;
-    int instruction_length = 0; /* represents the num of operands */
-    static char *instructionType;
-    int encodeErr;
-    char instructionTypeBuffer[LINE_SIZE];
-    
-    /* skip label word if exists */
-    if (LABEL_FLAG == 1) {
-        line = skipFirstWord(line);
+        /* check for a second operand */
+        if (f -> kind == FIXUP_ENTRY_EXCESS) {
+            diagPrintf(DIAG_ENTRY_EXTERN, f -> line_num, "\nERROR: in file \"%s\", line %d, Invalid num of operands after the \".entry\" definition.\n", file_name, f -> line_num);
+            return 0;
+        }
+        return 1;
     }
-    
-    replaceCommas(line); /* replace commas with spaces */
-    
-    instructionType = get_first_word(line); /* get the instruction word */
-    line = skipFirstWord(line); /* skip instruction word */
 
-    IC += 1;
-    L += 1;
-    L += findNumOfWords(line); /* get num of words excluding the label */
-    
-    /* save instruction-type word as a buffer */ 
-	strncpy(instructionTypeBuffer, instructionType, strlen(instructionType));
-	instructionTypeBuffer[sizeof(instructionType)-1] = '\0'; 
-
-    /* in case there are 0 operands */
-    if (*line == '\0' || *line == '\n') {
-        return L;
-    }
-
-    /* find how many operands there are in the line */
-    instruction_length = findNumOfWords(line);
-
-    switch (instruction_length) 
-    {
-        /* one operand */
-        case 1:
-        {
-            /* check addressing type of the operand */
-            char *operand = get_first_word(line); /* get the operand word */
-            int addressing_type = getAddressingType(file_name, line_num, operand, instructionTypeBuffer);
-
-            if (addressing_type == 1) {
-
-                /* check if the label was already encoded in the first-stage */
-                if (LabelWasAlreadyEncoded(IC) == 1) {
-                    return L; /* success */
-                }
-
-                /* encode the mila in the correct place */
-                if (encodeLabelMila(operand, IC) == 0) {
-                    return -2; /* memory error */
-                }
-            }
-            else if (addressing_type == -2) {
-                printf("\nERROR: in file \"%s\", line %d, operand after instruction of type \"%s\" is invalid.\n", file_name, line_num, instructionTypeBuffer);
-                return -1;
-            }
-
-            return L; /* success*/
-        }
+    /* the operand is still not a label, so it's an unknown word */
+    if (label == NULL) {
+        diagPrintf(DIAG_LABEL_UNKNOWN, f -> line_num, "\nERROR: in file \"%s\", line %d, %soperand after instruction of type \"%s\" is invalid.\n", file_name, f -> line_num, operandPlace[f -> operand], OPCODES[f -> opcode].name);
+        return 0;
+    }
 
-        /* two operands */
-        case 2:
-        {
-            /* get first and second operands: */
-            char *first_operand = get_first_word(line); 
-            char *second_operand = get_second_word(line); 
-            
-            /* get addressing type of the operands: */
-            int first_addressing_type = getAddressingType(file_name, line_num, first_operand, instructionTypeBuffer);
-            int second_addressing_type = getAddressingType(file_name, line_num, second_operand, instructionTypeBuffer);
-            
-            /* SPECIAL CASE - when two of the adressing types are either 2 or 3 */
-            if ((first_addressing_type == 2 || first_addressing_type == 3) && (second_addressing_type == 2 || second_addressing_type == 3)) {
-                return L; /* this was already handled in first-stage */
-            }
-
-            /* encode the first operand (second mila)*/
-
-            /* First operand may be a label definition */
-            if (first_addressing_type == 1)  {
-                
-                /* encode the first operand as long as the label was not encoded in the first-stage */
-                if (encodeLabelMila(first_operand, IC) == 0 && LabelWasAlreadyEncoded(IC) == 0) {
-                    return -2; /* memory error */
-                }    
-            }
-            /* Second operand may be a future label */
-            if (second_addressing_type == 1) {
-                /* encode the second operand as long as the label was not encoded in the first-stage */
-                IC++;;
-                if (encodeLabelMila(second_operand, IC) == 0 && LabelWasAlreadyEncoded(IC) == 0) {
-                    return -2; /* memory error */
-                }    
-            }
-
-            /* Deal in case the operand may not be a label */
-            if (first_addressing_type == -2) {
-                /* unknown word */
-                printf("\nERROR: in file \"%s\", line %d, first operand after instruction of type \"%s\" is invalid.\n", file_name, line_num, instructionTypeBuffer);
-                return -1;
-            }
-            if (second_addressing_type == -2) {
-                /* unknown word */
-                printf("\nERROR: in file \"%s\", line %d, second operand after instruction of type \"%s\" is invalid.\n", file_name, line_num, instructionTypeBuffer);
-                return -1;
-            }
-
-            return L; /* success*/
-        }
+    /* encode the mila in the correct place */
+    encodeErr = encodeLabelMila(label, f -> address);
+    if (encodeErr == 0) {
+        return 2; /* memory error */
+    }
+    else if (encodeErr == 2) {
+        diagPrintf(DIAG_LABEL_ADDRESS, f -> line_num, "\nERROR: in file \"%s\", line %d, the address %d of label \"%s\" doesn't fit in an operand word (at most %d).\n", file_name, f -> line_num, label -> value, getName(label -> name_id), MAX_LABEL_ADDRESS);
+        return 0;
     }
+    return 1;
 }
 
 
 /* this function encodes a mila as an adressing type of 1 (ie label) to the instruction-memory-image,
+ * patching the cell in place at address IC. it returns:
 1 - success
-0 - memmory error */
-int encodeLabelMila(char *operand, int IC)
+0 - memmory error
+2 - the address of the label doesn't fit in the operand word (a memory bigger than MAX_LABEL_ADDRESS, "--mem-words") */
+int encodeLabelMila(Lptr label, int IC)
 {
-	char *labelStatus = getLabelStatus(operand); /* get the label type ie. ".external" etc... */
-	int Labeladdress = getLabelAddress(operand); /* get the label address */
 	/* create the second mila */
-	ALLOCATE_NODE; /* returns 0 when memory-error */		
 	CREATE_AND_RESET_MILA;
-	if (strcmp(labelStatus, ".external") == 0) {
+	if (label -> kind == LABEL_EXTERNAL) {
 		space.MILA |= 1; /* set E in ARE to 1 */
-		/* complete node */
-		insertDataToNode(t, space, IC); 
-		assignNodeToList(t);
+		STORE_MILA(IC); /* complete the cell in the instruction image */
+
+		/* record the use of the external label for the .ext file */
+		if (addExternUse(label -> name_id, IC) == 0) {
+			return 0;
+		}
 		return 1;
 	}
 	else {
+		if (label -> value > MAX_LABEL_ADDRESS) {
+			return 2;
+		}
 		space.MILA |= (1 << 1);; /* set R in ARE to 1 */
-		space.MILA |= ((Labeladdress) << 3); /* add label addrress between 3-14 bits */
-		/* complete node */
-		insertDataToNode(t, space, IC); 
-		assignNodeToList(t);
+		space.MILA |= ((label -> value) << 3); /* add label addrress between 3-14 bits */
+		STORE_MILA(IC); /* complete the cell in the instruction image */
 		return 1;
 	}
 	
 }
 
 
-/* Given a line, this function returns the number of words in the line */
-int findNumOfWords(char *line) {
-    int length_num = 0;
-    
-    /* Skip leading spaces */
-    while (*line && isspace(*line)) {
-        line++;
-    }
-    
-    while (*line && *line != '\n') {
-        /* Ensure the current position is the start of a word */
-        if (!isspace(*line)) {
-            length_num++;
-            line = skipFirstWord(line); /* Move to the next word */
-        }
-    }
-    return length_num;
+/*
+ * countInstructionCell - Returns the number of memory cells in the instruction image.
+ * Return: The number of memory cells in the instruction image.
+ */
+int countInstructionCell()
+{
+    return Ctx -> instruction_image.size;
 }
 
 
 /*
- * LabelWasAlreadyEncoded - Checks if a given address exists in the instruction memory image.
- * @IC: The instruction counter address to be checked.
- * 
- * Return: 1 if address found, 0 if not found.
+ * countDataCell - Returns the number of memory cells in the data image.
+ * Return: The number of memory cells in the data image.
  */
-int LabelWasAlreadyEncoded(int IC)
+int countDataCell()
 {
-	/* traversing the linked list */
-    Iptr p = Instruction_hptr;
-    while (p) {
-		if (p -> address == IC) {
-            return 1; /* found */
-        }
-        p = p->next;
-    }   
-
-    return 0;
+    return Ctx -> data_image.size;
 }
 
 
+/* every pair of decimal digits ("00" to "99"), the numbers of the output files are formatted two digits at a time */
+static const char decimalPairs[] =
+    "0001020304050607080910111213141516171819202122232425262728293031323334353637383940414243444546474849"
+    "5051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+
+/* the octal digits, a 15-bit word is formatted 3 bits at a time */
+static const char octalDigits[] = "01234567";
+
+
 /*
- * countInstructionCell - Counts and returns the number of memory cells in the instruction image.
- * Return: The number of memory cells in the instruction image.
+ * formatDecimal - Formats a non-negative number in decimal, the same way "%0*d" does.
+ * @out: The buffer to be filled (not null-terminated), it must have room for 10 characters.
+ * @value: The number to be formatted.
+ * @min_digits: The minimal num of digits, the number is padded with leading zeros.
+ *
+ * Return: The num of characters written.
  */
-int countInstructionCell()
+int formatDecimal(char *out, int value, int min_digits)
 {
-    int total_num = 0;
-    Iptr p = Instruction_hptr;
-
-    while (p) {
-        total_num++;
-        p = p->next;
-    }
-
-    return total_num;
+    char digits[10];
+    char *p = digits + sizeof(digits); /* the digits are formatted from the end */
+    unsigned int u = (value < 0) ? 0 : value;
+    int length;
+
+    while (u >= 100) {
+        int pair = (u % 100) * 2;
+        u /= 100;
+        *--p = decimalPairs[pair + 1];
+        *--p = decimalPairs[pair];
+    }
+    if (u >= 10) {
+        *--p = decimalPairs[u * 2 + 1];
+        *--p = decimalPairs[u * 2];
+    } else {
+        *--p = (char) ('0' + u);
+    }
+    while (digits + sizeof(digits) - p < min_digits) {
+        *--p = '0';
+    }
+
+    length = digits + sizeof(digits) - p;
+    memcpy(out, p, length);
+    return length;
 }
 
 
 /*
- * countDataCell - Counts and returns the number of memory cells in the data image.
- * Return: The number of memory cells in the data image.
+ * formatOctalWord - Formats a 15-bit word in octal, the same way "%05o" does.
+ * @out: The buffer to be filled with exactly 5 characters (not null-terminated).
+ * @word: The word to be formatted, only its 15 lower bits are used.
  */
-int countDataCell()
+void formatOctalWord(char *out, unsigned int word)
 {
-    int total_num = 0;
-    Dptr t = Data_hptr;
-    while (t) {
-        
-        total_num++;
-        t = t->next;
-    }
-    
-    return total_num;
+    out[0] = octalDigits[(word >> 12) & 7];
+    out[1] = octalDigits[(word >> 9) & 7];
+    out[2] = octalDigits[(word >> 6) & 7];
+    out[3] = octalDigits[(word >> 3) & 7];
+    out[4] = octalDigits[word & 7];
 }
 
 
 /*
  * write2Object - Writes the output object file data.
  * @obj: The file pointer to the object file.
+ *
+ * The whole file is formatted into a single buffer, and written at once.
+ *
+ * Return: 1 on success, 0 on memory error.
  */
-void write2Object(FILE *obj)
+int write2Object(FILE *obj)
 {
-    /* Helper function to print a binary number with leading zeros */
-    void print_binary(FILE *obj, int num, int bits) {
-        for (int i = bits - 1; i >= 0; i--) {
-            fprintf(obj, "%d", (num >> i) & 1);
-        }
-    }
-
     int sum_instruction_cell = countInstructionCell(); /* represents the sum of instruction cells */
     int sum_data_cell = countDataCell(); /* represents the sum of data cells */
     int total_cells = sum_instruction_cell + sum_data_cell;
+    char *buffer;
+    char *out;
     int i;
 
+    /* the header, and a line of "address word" for every cell: at most 10 + 1 + 5 + 1 characters */
+    buffer = (char *) malloc(2 * 10 + 2 + total_cells * 17);
+    STAT_COUNT(allocations);
+    if (buffer == NULL) {
+        return 0; /* memory error */
+    }
+    out = buffer;
+
     /* write the sum data at the top */
-    fprintf(obj, "%d %d", sum_instruction_cell, sum_data_cell); 
-    fprintf(obj, "\n");
+    out += formatDecimal(out, sum_instruction_cell, 1);
+    *out++ = ' ';
+    out += formatDecimal(out, sum_data_cell, 1);
+    *out++ = '\n';
 
     /* write memory-address + cell */
     for (i = 0; i < total_cells; i++) {
-        
-        int address = i + 100; /* Calculate the address */
+        out += formatDecimal(out, i + FIRST_ADDRESS, 4); /* address in decimal format with 4 digits */
+        *out++ = ' ';
+        formatOctalWord(out, memoryWord(i + FIRST_ADDRESS)); /* the 15-bit cell in octal format with 5 digits */
+        out += 5;
+        *out++ = '\n';
+    }
 
-        fprintf(obj, "%04d ", address); /* Write address in decimal format with 4 digits */
+    fwrite(buffer, 1, out - buffer, obj);
+    free(buffer);
+    return 1;
+}
 
-        /* Write the memory cell content in octal format with 5 digits */
-        fprintf(obj, "%05o\n", memory_image[i + 100].MILA & 077777); /* 077777 is the octal representation of a 15-bit mask */
-    }
+
+/*
+ * writeLabelLine - Writes a "name number" line into a text buffer.
+ * @buffer: The text buffer.
+ * @name: The label name.
+ * @value: The number.
+ * @min_digits: The minimal num of digits of the number.
+ *
+ * Return: 1 on success, 0 on memory error.
+ */
+int writeLabelLine(text_buffer *buffer, const char *name, int value, int min_digits)
+{
+    char number[12];
+    int length = formatDecimal(number, value, min_digits);
+    number[length++] = '\n';
+
+    return appendText(buffer, name, strlen(name)) && appendText(buffer, " ", 1) && appendText(buffer, number, length);
 }
 
 
-/* This function writes the output entry file data with a given pointer to file */
-void write2Ent(FILE *ent)
+/*
+ * write2Ent - Writes the output entry file data.
+ * @ent: The file pointer to the entry file.
+ *
+ * The labels are taken from the output plan, in the order they were defined,
+ * formatted into a single buffer and written at once.
+ *
+ * Return: 1 on success, 0 on memory error.
+ */
+int write2Ent(FILE *ent)
 {
-    Lptr p = Labelhptr;
-    while (p) {
+    text_buffer buffer = {NULL, 0, 0};
+    int i;
+
+    for (i = 0; i < Ctx -> output_plan.num_of_entries; i++) {
+        Lptr p = plannedEntry(i);
 
-        /* found an .entry label*/
-        if (strcmp(p->type, ".entry") == 0) {
-            /* write label to file */
-            fprintf(ent, "%s %d\n", p->label_name, p->value);
+        if (writeLabelLine(&buffer, getName(p -> name_id), p -> value, 1) == 0) {
+            free(buffer.text);
+            return 0; /* memory error */
         }
-        p = p->next;
     }
+
+    fwrite(buffer.text, 1, buffer.size, ent);
+    free(buffer.text);
+    return 1;
 }
 
 
@@ -441,16 +332,7 @@ void write2Ent(FILE *ent)
  */
 int entryLabelsExists()
 {
-    Lptr p = Labelhptr;
-    while (p) {
-
-        if (strcmp(p->type, ".entry") == 0) {
-            return 1;
-        }
-        p = p->next;
-    }
-
-    return 0;
+    return Ctx -> output_plan.num_of_entries > 0;
 }
 
 
@@ -460,172 +342,261 @@ int entryLabelsExists()
  */
 int externLabelExists()
 {
-    Lptr p = Labelhptr;
-    while (p) {
-
-        if (strcmp(p -> type, ".external") == 0) {
-            return 1;
-        }
-        p = p->next;
-    }
-
-    return 0;
+    return Ctx -> output_plan.num_of_externs > 0;
 }
 
 
-/* This function sorts and load the instruction-image and the data-image to the PC memory in order, then returns 1 */
+/* This function loads the instruction-image and the data-image to the PC memory in order.
+ * it returns 1 on success, 0 when the images don't fit in the PC memory, 2 on memory error */
 int loadPCMemory()
 {
-    int AC = 0; /* address counter */
-
-    /* Load instruction-memory image to the main PC memory-image: */
-    Iptr p = Instruction_hptr;
-    Dptr t = Data_hptr;
-    while (p) {
-        
-        /* check if the address doesn't match */
-        if (p->address != AC) {
-            
-            Iptr t = Instruction_hptr;
-            int foundNode = 0;
-            /* find the missing cell */
-            while (t) {
-                if (t->address == AC) {
-                    /* missing cell found */
-                    memory_image[AC+100] = t->cell;
-                    foundNode = 1;
-                    break;
-                }
-
-                t = t->next;
-            }
-            /* if didn't find cell, exit */
-            if (foundNode = 0) {
-                break;
-            }
-        }
-        else {
-            /* address does match, add the current cell */
-            memory_image[AC+100] = p->cell;
-        }
+    int AC = Ctx -> instruction_image.size; /* address counter */
 
-        AC++;
-        p = p->next;
+    if (FIRST_ADDRESS + AC + Ctx -> data_image.size > MEMORY_WORDS) {
+        return 0; /* surpassing the memory limit */
     }
 
-    /* Load data-memory image to the main PC memory-image: */
-    while (t) {
-        memory_image[AC+100] = t->cell;
-        AC++;
-        t = t->next;
+    /* Load instruction-memory image to the main PC memory-image (it's already sorted by address): */
+    if (storeWords(FIRST_ADDRESS, Ctx -> instruction_image.cells, AC) == 0) {
+        return 2; /* memory error */
     }
 
+    /* Load data-memory image to the main PC memory-image, right after the instructions: */
+    if (storeWords(FIRST_ADDRESS + AC, Ctx -> data_image.cells, Ctx -> data_image.size) == 0) {
+        return 2; /* memory error */
+    }
 
     return 1;
 }
 
 
+/* Helper function to print a 15-bit word in binary */
+static void printBinary(int n)
+{
+    int i;
+    unsigned int mask = 1 << 14; /* This sets the mask to the highest bit (15th bit)*/
+    for (i = 0; i < 15; i++) {
+        if(n & mask) {
+            logPrintf("1");
+        } else {
+            logPrintf("0");
+        }
+        mask >>= 1; /* Shift the mask one position to the right */
+    }
+}
+
+
 /* NOTICE: This is a helper function and it does not have a use in the assembler at all.
  * This function prints the PC memory until it reaches a given n limit */
 void printPCmemory(int n)
 {
-    printf("PC-Memory-Image:\n");
-    /* Helper function to print an integer in binary */
-    void printBinary(int n) {
-		int i;
-        unsigned int mask = 1 << 14; /* This sets the mask to the highest bit (15th bit)*/
-        for (i = 0; i < 15; i++) {
-            if(n & mask) {
-                printf("1");
-            } else {
-                printf("0");
-            }
-            mask >>= 1; // Shift the mask one position to the right
+    int i;
+
+    logPrintf("PC-Memory-Image:\n");
+    logPrintf("\n");
+    for (i = FIRST_ADDRESS; i < n; i++) {
+        logPrintf("%d:    ", i);
+        printBinary(memoryWord(i));
+        logPrintf("\n");
+    }
+}
+
+
+/*
+ * createBinaryOutput - Creates the binary object file "output/<name>.bin".
+ * @file_name: The name of the file being processed.
+ *
+ * Return: 1 on success, 0 if the file can't be written, 2 on memory error.
+ */
+static int createBinaryOutput(char *file_name)
+{
+    char bin_name[256 + 12];
+    output_file bin;
+
+    sprintf(bin_name, "output/%s.bin", file_name);
+
+    /* open file */
+    if (openOutput(&bin, bin_name, "wb") == NULL) {
+        diagPrintf(DIAG_OUTPUT_FILE, 0, "ERROR: Unable to create binary object file: \"%s\".\n", bin_name);
+        return 0; /* moving to the next file */
+    }
+
+    /* write the binary object file */
+    if (write2Binary(bin.fp) == 0) {
+        diagPrintf(DIAG_NO_MEMORY, 0, "ERROR: in file \"%s\", unable to allocate memory for the binary object file.\n", file_name);
+        discardOutput(&bin);
+        return 2; /* memory error */
+    }
+    if (closeOutput(&bin) == 0) {
+        diagPrintf(DIAG_OUTPUT_FILE, 0, "ERROR: Unable to create binary object file: \"%s\".\n", bin_name);
+        return 0;
+    }
+    return 1;
+}
+
+
+/*
+ * createStreamOutput - Writes the output files to stdout, as a single stream ("-").
+ * @file_name: The name of the file being processed.
+ *
+ * In the text format, every file is a section that starts with a line of its own (".ob", ".ent" and ".ext",
+ * always in this order, even when the .ent or the .ext section is empty), and the stream ends with a ".end"
+ * line. In the binary format, the stream is the binary object file itself.
+ *
+ * Return: 1 on success, 0 if the stream can't be written, 2 on memory error.
+ */
+static int createStreamOutput(char *file_name)
+{
+    int write_err;
+
+    if (OUTPUT_FORMAT == FORMAT_BIN) {
+        write_err = write2Binary(stdout);
+    } else {
+        fputs(STREAM_OBJECT, stdout);
+        write_err = write2Object(stdout);
+        if (write_err == 1) {
+            fputs(STREAM_ENTRIES, stdout);
+            write_err = write2Ent(stdout);
+        }
+        if (write_err == 1) {
+            fputs(STREAM_EXTERNS, stdout);
+            write_err = write2Extern(stdout);
+        }
+        if (write_err == 1) {
+            fputs(STREAM_END, stdout);
         }
     }
 
-    int i;
-    printf("\n");
-    for (i = 100; i < n; i++) {
-        printf("%d:    ", i);
-        printBinary(memory_image[i].MILA);
-        printf("\n");
+    if (write_err == 0) {
+        diagPrintf(DIAG_NO_MEMORY, 0, "ERROR: in file \"%s\", unable to allocate memory for the output stream.\n", file_name);
+        return 2; /* memory error */
+    }
+    if (fflush(stdout) != 0 || ferror(stdout)) {
+        diagPrintf(DIAG_OUTPUT_FILE, 0, "ERROR: Unable to write the output stream of file \"%s\".\n", file_name);
+        return 0;
     }
+    return 1;
 }
 
 
 /*
  * createOutput - Creates the output files.
  * @file_name: The name of the file being processed.
- * @fp: The file pointer to the source file.
  * 
- * Return: 1 on success, 0 on memory error.
+ * The files are written from the output plan and the memory image, every file is written to a
+ * temporary file first ("openOutput"), so an output file is either complete or left as it was.
+ *
+ * Return: 0 - regular error (the memory image surpasses the memory limit, or an output file can't be written)
+ *         1 - success
+ *         2 - memory error
  */
-int createOutput(char *file_name, int line_num, FILE *fp)
+int createOutput(char *file_name)
 {
     #define EXTRA_OBJ_NAME_SPACE 11
     #define EXTRA_ENT_NAME_SPACE 12
     #define EXTRA_EXT_NAME_SPACE 12
-    FILE *obj = NULL;
-    FILE *ent = NULL;
-    FILE *ext = NULL;
+    char obj_name[256 + EXTRA_OBJ_NAME_SPACE];
+    char ent_name[256 + EXTRA_ENT_NAME_SPACE];
+    char ext_name[256 + EXTRA_EXT_NAME_SPACE];
+    output_file obj;
+    output_file ent;
+    output_file ext;
+    int load_err;
+
+    /* load the data into the PC memory */
+    STAT_BEGIN(STAGE_LOAD);
+    load_err = loadPCMemory();
+    if (load_err == 0) {
+        diagPrintf(DIAG_MEMORY_LIMIT, 0, "\nERROR: in file \"%s\", the memory image surpasses the memory limit of %d.\n", file_name, MEMORY_WORDS);
+        return 0;
+    }
+    else if (load_err == 2) {
+        diagPrintf(DIAG_NO_MEMORY, 0, "ERROR: in file \"%s\", unable to allocate memory for the memory image.\n", file_name);
+        return 2; /* memory error */
+    }
+    STAT_END(STAGE_LOAD);
 
-    loadPCMemory(); /* sort the data into the PC memory */
+    /* only the linked image is written */
+    if (OUTPUT_FILES == 0) {
+        return 1;
+    }
+
+    /* the output files are written to stdout */
+    if (OUTPUT_STREAM == 1) {
+        return createStreamOutput(file_name);
+    }
+
+    /* the binary object file replaces all the text files */
+    if (OUTPUT_FORMAT == FORMAT_BIN) {
+        return createBinaryOutput(file_name);
+    }
     
     /* create object file name */
-    int obj_length = strlen(file_name) + EXTRA_OBJ_NAME_SPACE;
-    char obj_name[obj_length];
-    memset(obj_name, 0, obj_length); // Initialize to zero
-    snprintf(obj_name, obj_length, "output/%s.ob", file_name);
+    sprintf(obj_name, "output/%s.ob", file_name);
 
     /* open file */
-    obj = fopen(obj_name, "w");
-    if (obj == NULL) {
-        printf("ERROR: Unable to create object file: \"%s\".\n", obj_name);
+    if (openOutput(&obj, obj_name, "w") == NULL) {
+        diagPrintf(DIAG_OUTPUT_FILE, 0, "ERROR: Unable to create object file: \"%s\".\n", obj_name);
         return 0; /* moving to the next file */
     }	
 
-    write2Object(obj); /* write the object file */
-    fclose(obj);
+    /* write the object file */
+    if (write2Object(obj.fp) == 0) {
+        diagPrintf(DIAG_NO_MEMORY, 0, "ERROR: in file \"%s\", unable to allocate memory for the object file.\n", file_name);
+        discardOutput(&obj);
+        return 2; /* memory error */
+    }
+    if (closeOutput(&obj) == 0) {
+        diagPrintf(DIAG_OUTPUT_FILE, 0, "ERROR: Unable to create object file: \"%s\".\n", obj_name);
+        return 0;
+    }
     
     /* check in case there is at least one ".entry" label */
     if (entryLabelsExists() == 1) {
 
         /* create the .entry file */
-        int ent_length = strlen(file_name) + EXTRA_ENT_NAME_SPACE;
-        char ent_name[ent_length];
-        memset(ent_name, 0, ent_length); // Initialize to zero
-        snprintf(ent_name, ent_length, "output/%s.ent", file_name);
+        sprintf(ent_name, "output/%s.ent", file_name);
 
         /* open file */
-        ent = fopen(ent_name, "w");
-        if (ent == NULL) {
-            printf("ERROR: Unable to create entry file: \"%s\".\n", ent_name);
+        if (openOutput(&ent, ent_name, "w") == NULL) {
+            diagPrintf(DIAG_OUTPUT_FILE, 0, "ERROR: Unable to create entry file: \"%s\".\n", ent_name);
             return 0; /* moving to the next file */
         }	
         
-        write2Ent(ent); /* write to the entry file */
-        fclose(ent);
+        /* write to the entry file */
+        if (write2Ent(ent.fp) == 0) {
+            diagPrintf(DIAG_NO_MEMORY, 0, "ERROR: in file \"%s\", unable to allocate memory for the entry file.\n", file_name);
+            discardOutput(&ent);
+            return 2; /* memory error */
+        }
+        if (closeOutput(&ent) == 0) {
+            diagPrintf(DIAG_OUTPUT_FILE, 0, "ERROR: Unable to create entry file: \"%s\".\n", ent_name);
+            return 0;
+        }
     }
 
     /* check in case there is at least one ".extern" label */
     if (externLabelExists() == 1) {
         
         /* create the .extern file */
-        int ext_length = strlen(file_name) + EXTRA_EXT_NAME_SPACE;
-        char ext_name[ext_length];
-        memset(ext_name, 0, ext_length); // Initialize to zero
-        snprintf(ext_name, ext_length, "output/%s.ext", file_name);
+        sprintf(ext_name, "output/%s.ext", file_name);
 
         /* open file */
-        ext = fopen(ext_name, "w");
-        if (ext == NULL) {
-            printf("ERROR: Unable to create extern file: \"%s\".\n", ext_name);
+        if (openOutput(&ext, ext_name, "w") == NULL) {
+            diagPrintf(DIAG_OUTPUT_FILE, 0, "ERROR: Unable to create extern file: \"%s\".\n", ext_name);
             return 0; /* moving to the next file */
         }	
 
-        write2Extern(file_name, line_num, ext, fp); /* write to the extern file */
-        fclose(ext);
+        /* write to the extern file */
+        if (write2Extern(ext.fp) == 0) {
+            diagPrintf(DIAG_NO_MEMORY, 0, "ERROR: in file \"%s\", unable to allocate memory for the extern file.\n", file_name);
+            discardOutput(&ext);
+            return 2; /* memory error */
+        }
+        if (closeOutput(&ext) == 0) {
+            diagPrintf(DIAG_OUTPUT_FILE, 0, "ERROR: Unable to create extern file: \"%s\".\n", ext_name);
+            return 0;
+        }
     }
     
     return 1;
@@ -635,220 +606,119 @@ int createOutput(char *file_name, int line_num, FILE *fp)
 /*
  * write2Extern - Writes the external labels data to the .ext file.
  * @ext: The file pointer to the .ext file.
- * @fp: The file pointer to the source file.
  * 
- * Return: 1 on success.
+ * Every use of an external label was recorded with its exact word address when it was encoded,
+ * and the list was sorted by address when the output plan was finished. The lines are formatted
+ * into a single buffer and written at once.
+ *
+ * Return: 1 on success, 0 on memory error.
  */
-int write2Extern(char *file_name, int line_num, FILE *ext, FILE *fp)
+int write2Extern(FILE *ext)
 {
-    int IC = 0; /* instruction word counter (used to find the location of the extern labels) */
-    char line[LINE_SIZE]; 
-    rewind(fp); /* reset source file pointer */
-    
-    /* Reading line after line */
-	while (fgets(line, sizeof(line), fp)) 
-	{
-        char *first_word = get_first_word(line); /* get first word */
-        int first_word_length = strlen(first_word);
-        int L;
-        char possible_label[first_word_length]; 
-        char *second_word;
-        char *third_word;
-        char *fourth_word;
-
-        replaceCommas(line); /* replace commas with whitespaces*/
-         
-        L = findNumOfWords(line); /* assign num of words */
-
-        /* Copy first word to another buffer as a possible label and remove the last character ':' */
-        if (first_word[first_word_length - 1] == ':') {
-            strncpy(possible_label, first_word, first_word_length - 1);
-            possible_label[first_word_length - 1] = '\0'; /* Null-terminate the string */
-        } else {
-            strncpy(possible_label, first_word, first_word_length);
-            possible_label[first_word_length] = '\0'; /* Null-terminate the string */
-        }
+    text_buffer buffer = {NULL, 0, 0};
+    int i;
 
-        /* replace all commas with whitespaces */
-        if (isAlreadyLabel(possible_label) == 1 || isLabel(line, file_name, line_num) == 3) {
-            replaceCommas(line + first_word_length); /* handles commas differently when label is declared */
-            L -= 1; /* exclude label word */
-        }
-        
-        /* get words */
-        second_word = get_second_word(line);
-        third_word = get_third_word(line);
-        fourth_word = get_fourth_word(line); 
-
-        /* skip if there's ".extern" OR ".entry" as a next word or if there's .data OR .string */
-        if (isExternORentry(first_word, second_word) == 1 || isDataORstring(first_word, second_word) == 1) {
-            continue;
-        }
-        
-        /* decrease IC by one if two of the operands are registers */
-        if (checkRegisters(second_word, third_word, fourth_word) == 1) {
-            L--;
+    for (i = 0; i < Ctx -> extern_uses.size; i++) {
+        if (writeLabelLine(&buffer, getName(Ctx -> extern_uses.items[i].name_id), Ctx -> extern_uses.items[i].address + FIRST_ADDRESS, 4) == 0) {
+            free(buffer.text);
+            return 0; /* memory error */
         }
-
-        print2ExternFile(possible_label, second_word, third_word, fourth_word, IC, ext); /* print the data to the file */
-        
-        IC += L; /* update IC */
     }
 
+    if (buffer.size > 0) {
+        fwrite(buffer.text, 1, buffer.size, ext);
+    }
+    free(buffer.text);
     return 1;
 }
 
 
 /*
- * print2ExternFile - Prints the data to the .ext file.
- * @label_name: The name of the label.
- * @second_word: The second word in the line.
- * @third_word: The third word in the line.
- * @fourth_word: The fourth word in the line.
- * @IC: The instruction counter address.
- * @ext: The file pointer to the .ext file.
+ * putWord32 - Stores an unsigned 32-bit number in little-endian order.
+ * @out: The buffer to be filled with exactly 4 bytes.
+ * @value: The number to be stored.
  */
-void print2ExternFile(char *label_name, char *second_word, char *third_word, char *fourth_word, int IC, FILE *ext)
+void putWord32(unsigned char *out, unsigned long value)
 {
-    /* search for labels */
-    if (isAlreadyLabel(label_name) == 1) {
-
-        /* skip past label (special case)*/
-        if (isExternLabel(third_word) == 1) {
-            /* write to file */
-            fprintf(ext, "%s %04d\n", third_word, IC+100 + 1);
-        }
-
-        if (isExternLabel(fourth_word) == 1) {
-            /* write to file */
-            fprintf(ext, "%s %04d\n", fourth_word, IC+100 + 2);
-        }
-    }
-    else {
-
-        if (isExternLabel(second_word) == 1) {
-            /* write to file */
-            fprintf(ext, "%s %04d\n", second_word, IC+100 + 1);
-
-        }
-
-        if (isExternLabel(third_word) == 1) {
-            /* write to file */
-            fprintf(ext, "%s %04d\n", third_word, IC+100 + 2);
-        }
-    }
+    out[0] = (unsigned char) (value & 0xff);
+    out[1] = (unsigned char) ((value >> 8) & 0xff);
+    out[2] = (unsigned char) ((value >> 16) & 0xff);
+    out[3] = (unsigned char) ((value >> 24) & 0xff);
 }
 
 
 /*
- * checkRegisters - Checks if at least two of the given words are registers.
- * @second_word: The second word to be checked.
- * @third_word: The third word to be checked.
- * @fourth_word: The fourth word to be checked.
- * 
- * Return: 1 if at least two are registers, 0 otherwise.
+ * putSymbol - Stores a symbol record of the binary object file.
+ * @out: The buffer to be filled with exactly ASM_BIN_SYMBOL_SIZE bytes.
+ * @name: The label name.
+ * @address: The address of the symbol.
  */
-int checkRegisters(char *second_word, char *third_word, char *fourth_word)
+void putSymbol(unsigned char *out, const char *name, int address)
 {
-    int i;
-    if ((isRegister(second_word) == 1 && isRegister(third_word)) == 1 || (isRegister(third_word) == 1 && isRegister(fourth_word) == 1)) {
-        return 1;
-    }
-    return 0;
+    memset(out, 0, ASM_BIN_NAME_SIZE);
+    strncpy((char *) out, name, ASM_BIN_NAME_SIZE - 1);
+    putWord32(out + ASM_BIN_NAME_SIZE, address);
 }
 
 
 /*
- * isRegister - Checks if a given word is a register.
- * @word: The word to be checked.
- * 
- * Return: 1 if the word is a register, 0 otherwise.
+ * write2Binary - Writes the binary object file (the layout is described in "assemble.h").
+ * @bin: The file pointer to the binary object file, opened in binary mode.
+ *
+ * The whole file is formatted into a single buffer, and written at once.
+ *
+ * Return: 1 on success, 0 on memory error.
  */
-int isRegister(char *word) 
+int write2Binary(FILE *bin)
 {
-    char *registers[] = {"r0", "r1", "r2", "r3", "r4", "r5", "r6", "r7", "*r0", "*r1", "*r2", "*r3", "*r4", "*r5", "*r6", "*r7"};
+    int sum_instruction_cell = countInstructionCell();
+    int sum_data_cell = countDataCell();
+    int total_cells = sum_instruction_cell + sum_data_cell;
+    int num_of_entries = Ctx -> output_plan.num_of_entries;
+    int symbols_offset = (ASM_BIN_HEADER_SIZE + total_cells * 2 + 3) & ~3; /* aligned to 4 bytes */
+    int size;
+    unsigned char *buffer;
+    unsigned char *out;
     int i;
-    for (i = 0; i < 16; i++) {
-        if (strcmp(registers[i], word) == 0) {
-            return 1; /* reguster found */
-        }
-    }
-    return 0; /* register wasn't found */
-}
-
-
-/*
- * isExternLabel - Checks if a given label is defined as external.
- * @label_name: The name of the label to be checked.
- * 
- * Return: 1 if the label is external, 0 if not found.
- */
-int isExternLabel(char *label_name)
-{
-    Lptr p = Labelhptr;
-    while (p) {
-
-        if ((strcmp(label_name, p->label_name) == 0) && (strcmp(p->type, ".external") == 0)) {
-
-            /* a label that matches the input label was found, tagged as "external" */
-            return 1; /* found matching label */
-        }
-        p = p->next;
-    }
-    return 0; /* label wasn't found */
-}
-
-
-/*
- * isDataORstring - Checks if the given words are ".data" or ".string".
- * @first_word: The first word to be checked.
- * @second_word: The second word to be checked.
- * 
- * Return: 1 if one of them is ".data" or ".string", 0 otherwise.
- */
-int isDataORstring(char *first_word, char *second_word) 
-{
-    if (strcmp(first_word, ".string") == 0 || strcmp(first_word, ".data") == 0 ||
-        strcmp(second_word, ".string") == 0 || strcmp(second_word, ".data") == 0) {
-        return 1;
-    }
-    return 0;
-}
 
-
-/*
- * isExternORentry - Checks if the given words are ".entry" or ".extern".
- * @first_word: The first word to be checked.
- * @second_word: The second word to be checked.
- * 
- * Return: 1 if one of them is ".entry" or ".extern", 0 otherwise.
- */
-int isExternORentry(char *first_word, char *second_word)
-{
-    if (strcmp(first_word, ".entry") == 0 || strcmp(first_word, ".extern") == 0 ||
-        strcmp(second_word, ".entry") == 0 || strcmp(second_word, ".extern") == 0) {
-        return 1;
+    size = symbols_offset + (num_of_entries + Ctx -> extern_uses.size) * ASM_BIN_SYMBOL_SIZE;
+    buffer = (unsigned char *) calloc(size, 1);
+    STAT_COUNT(allocations);
+    if (buffer == NULL) {
+        return 0; /* memory error */
+    }
+
+    /* the header */
+    memcpy(buffer, ASM_BIN_MAGIC, 4);
+    putWord32(buffer + 4, ASM_BIN_VERSION);
+    putWord32(buffer + 8, sum_instruction_cell);
+    putWord32(buffer + 12, sum_data_cell);
+    putWord32(buffer + 16, FIRST_ADDRESS);
+    putWord32(buffer + 20, num_of_entries);
+    putWord32(buffer + 24, Ctx -> extern_uses.size);
+    putWord32(buffer + 28, symbols_offset);
+
+    /* the words */
+    out = buffer + ASM_BIN_HEADER_SIZE;
+    for (i = 0; i < total_cells; i++) {
+        unsigned int word = memoryWord(i + FIRST_ADDRESS) & 0x7fff;
+        *out++ = (unsigned char) (word & 0xff);
+        *out++ = (unsigned char) (word >> 8);
     }
-    return 0;
-}
 
-
-/* This function checks whether there are excess operands after the entry definition, if it found excess operands it returns 1, otherwise, 0. */
-int check4OperandEntry(char *file_name, int line_num, char *line, int LABEL_FLAG)
-{
-    if (LABEL_FLAG == 1) {
-        char *fourth_word = get_fourth_word(line);        
-        if (fourth_word != "") {   
-            printf("\nERROR: in file \"%s\", line %d, Invalid num of operands after the \".entry\" definition.\n", file_name, line_num);
-            return 1;
-        }
-        return 0;
+    /* the entries, and then the externs */
+    out = buffer + symbols_offset;
+    for (i = 0; i < num_of_entries; i++) {
+        Lptr p = plannedEntry(i);
+        putSymbol(out, getName(p -> name_id), p -> value);
+        out += ASM_BIN_SYMBOL_SIZE;
     }
-    char *third_word = get_third_word(line);
-    if (third_word != "") {       
-        printf("\nERROR: in file \"%s\", line %d, Invalid num of operands after the \".entry\" definition.\n", file_name, line_num);
-        return 1;
+    for (i = 0; i < Ctx -> extern_uses.size; i++) {
+        putSymbol(out, getName(Ctx -> extern_uses.items[i].name_id), Ctx -> extern_uses.items[i].address + FIRST_ADDRESS);
+        out += ASM_BIN_SYMBOL_SIZE;
     }
 
-    return 0;
-}
\ No newline at end of file
+    fwrite(buffer, 1, size, bin);
+    free(buffer);
+    return 1;
+}
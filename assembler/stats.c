@@ -0,0 +1,153 @@
+/*
+ * stats.c - This file prints the statistics of the assembler ("--stats").
+ * Every file counts its own statistics in its context (the time of every stage, the num of source lines,
+ * label and macro lookups, label list walks and allocations), they're printed to stderr once the file is
+ * done, as text or as a JSON line, and summed up for all the files at the end of the run.
+ * The counting itself is built in only with "make STATS=1", see the STAT_ macros in assembler.h.
+ */
+
+#define _XOPEN_SOURCE 600 /* clock_gettime, getrusage */
+#include <time.h>
+#include <sys/resource.h>
+#include "assembler.h"
+
+
+int STATS_FORMAT = STATS_OFF;
+
+/* the statistics of all the files, only the main thread prints (and sums) them */
+static asm_stats total_stats;
+static int total_files = 0;
+
+
+/*
+ * statsClock - Returns the current time of a monotonic clock.
+ *
+ * Return: The time in seconds.
+ */
+double statsClock()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+/*
+ * stageTotal - Returns the total time of the stages of a file.
+ * @s: The statistics of the file.
+ *
+ * Return: The time in seconds (loadPCMemory is already a part of the output stage).
+ */
+static double stageTotal(asm_stats *s)
+{
+	return s -> stage_time[STAGE_PRE_ASSEMBLER] + s -> stage_time[STAGE_FIRST] +
+		s -> stage_time[STAGE_SECOND] + s -> stage_time[STAGE_OUTPUT];
+}
+
+
+/*
+ * linesPerSecond - Returns the assembling rate of a num of lines.
+ * @lines: The num of source lines.
+ * @seconds: The time it took.
+ *
+ * Return: The num of lines per second, 0 when no time was measured.
+ */
+static double linesPerSecond(long lines, double seconds)
+{
+	return (seconds > 0) ? lines / seconds : 0;
+}
+
+
+/*
+ * printStats - Prints the timing and the counters of a statistics record.
+ * @title: The text title, or the first JSON field (with its trailing comma).
+ * @s: The statistics.
+ * @seconds: The time the lines/sec rate is calculated by.
+ */
+static void printStats(const char *title, asm_stats *s, double seconds)
+{
+	if (STATS_FORMAT == STATS_JSON) {
+		fprintf(stderr, "{%s\"time\":{\"pre_assembler\":%.6f,\"first_stage\":%.6f,\"second_stage\":%.6f,"
+			"\"create_output\":%.6f,\"load_pc_memory\":%.6f,\"total\":%.6f},", title,
+			s -> stage_time[STAGE_PRE_ASSEMBLER], s -> stage_time[STAGE_FIRST], s -> stage_time[STAGE_SECOND],
+			s -> stage_time[STAGE_OUTPUT], s -> stage_time[STAGE_LOAD], stageTotal(s));
+		fprintf(stderr, "\"lines\":%ld,\"lines_per_sec\":%.0f,\"label_lookups\":%ld,\"macro_lookups\":%ld,"
+			"\"list_walks\":%ld,\"allocations\":%ld", s -> lines, linesPerSecond(s -> lines, seconds),
+			s -> label_lookups, s -> macro_lookups, s -> list_walks, s -> allocations);
+		return;
+	}
+
+	fprintf(stderr, "%s: pre-assembler %.6fs, first stage %.6fs, second stage %.6fs, output %.6fs (loadPCMemory %.6fs), total %.6fs\n",
+		title, s -> stage_time[STAGE_PRE_ASSEMBLER], s -> stage_time[STAGE_FIRST], s -> stage_time[STAGE_SECOND],
+		s -> stage_time[STAGE_OUTPUT], s -> stage_time[STAGE_LOAD], stageTotal(s));
+	fprintf(stderr, "  %ld lines (%.0f lines/sec), %ld label lookups, %ld macro lookups, %ld label list walks, %ld allocations\n",
+		s -> lines, linesPerSecond(s -> lines, seconds), s -> label_lookups, s -> macro_lookups, s -> list_walks, s -> allocations);
+}
+
+
+/*
+ * printFileStats - Prints the statistics of a file, and adds them to the summary.
+ * @file_name: Name of the file.
+ * @s: The statistics of the file.
+ */
+void printFileStats(char *file_name, asm_stats *s)
+{
+	char title[256 * JSON_ESCAPE_SIZE + 32]; /* a file name is less than 256 characters, every one of them may be escaped */
+	char *out = title;
+	int i;
+
+	if (STATS_FORMAT == STATS_JSON) {
+		/* the file name as a JSON string */
+		out += sprintf(out, "\"file\":\"");
+		for (i = 0; file_name[i] != '\0'; i++) {
+			out += escapeJson(file_name[i], out);
+		}
+		sprintf(out, "\",");
+		printStats(title, s, stageTotal(s));
+		fprintf(stderr, "}\n");
+	} else {
+		sprintf(title, "Stats of file \"%s\"", file_name);
+		printStats(title, s, stageTotal(s));
+	}
+
+	/* add to the summary */
+	for (i = 0; i < NUM_OF_STAGES; i++) {
+		total_stats.stage_time[i] += s -> stage_time[i];
+	}
+	total_stats.lines += s -> lines;
+	total_stats.label_lookups += s -> label_lookups;
+	total_stats.macro_lookups += s -> macro_lookups;
+	total_stats.list_walks += s -> list_walks;
+	total_stats.allocations += s -> allocations;
+	total_files++;
+}
+
+
+/*
+ * printStatsSummary - Prints the statistics of all the files.
+ * @wall_time: The wall time of the whole run, in seconds.
+ *
+ * The stage times are summed over the files (with "-j" they're longer than the wall time),
+ * the lines/sec rate is calculated by the wall time of the run. The peak memory is the peak resident
+ * set size of the process ("getrusage"), so it counts the code, the stacks and libc along with the heap.
+ */
+void printStatsSummary(double wall_time)
+{
+	struct rusage usage;
+	char title[64];
+	long peak_rss_kb = 0;
+
+	if (getrusage(RUSAGE_SELF, &usage) == 0) {
+		peak_rss_kb = usage.ru_maxrss;
+	}
+
+	if (STATS_FORMAT == STATS_JSON) {
+		sprintf(title, "\"summary\":{\"files\":%d,", total_files);
+		printStats(title, &total_stats, wall_time);
+		fprintf(stderr, ",\"wall_time\":%.6f,\"peak_rss_kb\":%ld}}\n", wall_time, peak_rss_kb);
+	} else {
+		sprintf(title, "Stats of all %d files", total_files);
+		printStats(title, &total_stats, wall_time);
+		fprintf(stderr, "  wall time %.6fs, peak RSS %ld KB\n", wall_time, peak_rss_kb);
+	}
+}
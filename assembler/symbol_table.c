@@ -0,0 +1,253 @@
+/*
+ * symbol_table.c - This file contains the hashed symbol table of the assembler.
+ * Every label name is interned exactly once and gets a numeric id. The names are kept in an
+ * open-addressing hash table, so finding a label (its name, value and type together) takes
+ * a single lookup instead of a walk over the whole label table.
+ * The labels are packed records in a single array, in definition order, so a pass over all of
+ * them is a scan over contiguous memory.
+ * The table belongs to the assembler context of the file ("symbols").
+ */
+
+#include "assembler.h"
+
+
+#define SYMBOL_TABLE_INIT_SIZE 256 /* initial num of hash buckets, must be a power of 2 */
+
+/* the symbol table of the current context */
+#define names (Ctx -> symbols.names)
+#define names_count (Ctx -> symbols.names_count)
+#define names_capacity (Ctx -> symbols.names_capacity)
+#define buckets (Ctx -> symbols.buckets)
+#define buckets_size (Ctx -> symbols.buckets_size)
+#define labels (Ctx -> symbols.labels)
+#define labels_count (Ctx -> symbols.labels_count)
+#define labels_capacity (Ctx -> symbols.labels_capacity)
+
+
+/*
+ * hashName - Calculates the hash value of a given name (FNV-1a).
+ * @name: The name to be hashed.
+ *
+ * NOTICE: the macro table hashes the macro names with this function too.
+ *
+ * Return: The hash value of the name.
+ */
+unsigned int hashName(const char *name)
+{
+	unsigned int hash = 2166136261u;
+	while (*name) {
+		hash ^= (unsigned char)*name++;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+
+/*
+ * findBucket - Finds the bucket of a given name.
+ * @name: The name to be searched.
+ * @hash: The hash value of the name.
+ *
+ * This function probes the hash table linearly starting from the home bucket of the name,
+ * until it reaches the bucket holding the name or an empty bucket.
+ *
+ * Return: The index of the bucket.
+ */
+static int findBucket(const char *name, unsigned int hash)
+{
+	int mask = buckets_size - 1;
+	int i = hash & mask;
+
+	while (buckets[i] != 0) {
+		s_name *s = &names[buckets[i] - 1];
+		if (s -> hash == hash && strcmp(s -> name, name) == 0) {
+			break; /* found the name */
+		}
+		i = (i + 1) & mask;
+	}
+	return i;
+}
+
+
+/*
+ * growBuckets - Doubles the num of buckets and rehashes all the interned names.
+ *
+ * Return: 1 on success, 0 on memory error.
+ */
+static int growBuckets()
+{
+	int new_size = (buckets_size == 0) ? SYMBOL_TABLE_INIT_SIZE : buckets_size * 2;
+	int *new_buckets = (int *) calloc(new_size, sizeof(int));
+	int id;
+	TABLE_GROWTH();
+
+	if (new_buckets == NULL) {
+		return 0;
+	}
+
+	free(buckets);
+	buckets = new_buckets;
+	buckets_size = new_size;
+
+	/* re-insert every interned name */
+	for (id = 0; id < names_count; id++) {
+		buckets[findBucket(names[id].name, names[id].hash)] = id + 1;
+	}
+	return 1;
+}
+
+
+/*
+ * internName - Returns the id of a given name, interning the name when it's new.
+ * @name: The name to be interned.
+ *
+ * Return: The id of the name, -1 on memory error.
+ */
+int internName(const char *name)
+{
+	unsigned int hash = hashName(name);
+	int i;
+	s_name *s;
+	STAT_COUNT(label_lookups);
+
+	/* keep the load factor under 3/4 */
+	if ((names_count + 1) * 4 > buckets_size * 3) {
+		if (growBuckets() == 0) {
+			return -1; /* memory error */
+		}
+	}
+
+	i = findBucket(name, hash);
+	if (buckets[i] != 0) {
+		return buckets[i] - 1; /* already interned */
+	}
+
+	/* make room for a new name */
+	if (names_count == names_capacity) {
+		int new_capacity = (names_capacity == 0) ? SYMBOL_TABLE_INIT_SIZE : names_capacity * 2;
+		s_name *new_names = (s_name *) realloc(names, new_capacity * sizeof(s_name));
+		TABLE_GROWTH();
+		if (new_names == NULL) {
+			return -1; /* memory error */
+		}
+		names = new_names;
+		names_capacity = new_capacity;
+	}
+
+	s = &names[names_count];
+	s -> name = arenaCopy(&Ctx -> arena, name);
+	if (s -> name == NULL) {
+		return -1; /* memory error */
+	}
+	s -> hash = hash;
+	s -> label = -1;
+
+	buckets[i] = names_count + 1;
+	return names_count++;
+}
+
+
+/*
+ * findNameId - Returns the id of a given name without interning it.
+ * @name: The name to be searched.
+ *
+ * Return: The id of the name, -1 if the name was never interned.
+ */
+int findNameId(const char *name)
+{
+	int i;
+	STAT_COUNT(label_lookups);
+
+	if (buckets_size == 0) {
+		return -1; /* the table is empty */
+	}
+
+	i = findBucket(name, hashName(name));
+	return buckets[i] - 1;
+}
+
+
+/*
+ * getName - Returns the interned name of a given id.
+ * @id: The id of the name.
+ *
+ * Return: The interned name.
+ */
+char *getName(int id)
+{
+	return names[id].name;
+}
+
+
+/*
+ * findLabel - Finds the label defined with a given name.
+ * @name: The label name to be searched.
+ *
+ * Return: The label record (name, value and kind), NULL if no such label is defined.
+ */
+Lptr findLabel(const char *name)
+{
+	int id = findNameId(name);
+	if (id == -1) {
+		return NULL;
+	}
+	return getLabelById(id);
+}
+
+
+/*
+ * getLabelById - Finds the label defined with the name of a given id.
+ * @id: The id of the label name.
+ *
+ * Return: The label record, NULL if no such label is defined.
+ */
+Lptr getLabelById(int id)
+{
+	return (names[id].label == -1) ? NULL : &labels[names[id].label];
+}
+
+
+/*
+ * newLabel - Appends a new label record to the label table, and binds it to its name.
+ * @name_id: The id of the label name, it must be already interned.
+ *
+ * Return: The new record (all zeros but its name), NULL on memory error.
+ */
+Lptr newLabel(int name_id)
+{
+	Lptr t;
+
+	if (labels_count == labels_capacity) {
+		int new_capacity = (labels_capacity == 0) ? LABEL_TABLE_INIT_SIZE : labels_capacity * 2;
+		l_item *new_labels = (l_item *) realloc(labels, new_capacity * sizeof(l_item));
+		TABLE_GROWTH();
+		if (new_labels == NULL) {
+			return NULL; /* memory error */
+		}
+		labels = new_labels;
+		labels_capacity = new_capacity;
+	}
+
+	t = &labels[labels_count];
+	memset(t, 0, sizeof(l_item));
+	t -> name_id = name_id;
+	names[name_id].label = labels_count++;
+	return t;
+}
+
+
+/*
+ * freeSymbolTable - Frees the table of the interned names, the hash table and the label table.
+ * NOTICE: the names themselves belong to the arena of the context.
+ */
+void freeSymbolTable()
+{
+	free(names);
+	free(buckets);
+	free(labels);
+	names = NULL;
+	buckets = NULL;
+	labels = NULL;
+	names_count = names_capacity = buckets_size = 0;
+	labels_count = labels_capacity = 0;
+}
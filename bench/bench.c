@@ -0,0 +1,166 @@
+/*
+ * bench.c - The benchmark of the assembler ("make bench").
+ * Every source file is assembled in memory by "assemble" (libassembler.a) a num of times, and the
+ * throughput and the latency of a single run are reported for every file. The source is read once,
+ * so the times don't include any file input or output.
+ * A source that doesn't assemble successfully fails the benchmark, the generated workloads must stay valid.
+ *
+ * usage: bench [-r repeats] file.as...
+ */
+
+#define _XOPEN_SOURCE 600 /* clock_gettime */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../assembler/assemble.h"
+
+
+#define DEFAULT_REPEATS 50
+
+
+/*
+ * now - Returns the current time of a monotonic clock, in seconds.
+ */
+static double now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+/*
+ * compareTimes - Compares two times (used by qsort).
+ */
+static int compareTimes(const void *a, const void *b)
+{
+	double x = *(const double *) a, y = *(const double *) b;
+	return (x > y) - (x < y);
+}
+
+
+/*
+ * readFile - Reads a whole file into memory.
+ * @name: Name of the file.
+ * @size: Filled with the num of characters in the file.
+ *
+ * Return: The text of the file, NULL if it couldn't be read.
+ */
+static char *readFile(const char *name, long *size)
+{
+	FILE *fp = fopen(name, "rb");
+	char *text;
+
+	if (fp == NULL) {
+		return NULL;
+	}
+	fseek(fp, 0, SEEK_END);
+	*size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+
+	text = (char *) malloc(*size + 1);
+	if (text != NULL) {
+		*size = fread(text, 1, *size, fp);
+	}
+	fclose(fp);
+	return text;
+}
+
+
+/*
+ * countLines - Returns the num of lines in a text.
+ */
+static long countLines(const char *text, long size)
+{
+	long lines = 0;
+	long i;
+	for (i = 0; i < size; i++) {
+		lines += (text[i] == '\n');
+	}
+	return lines;
+}
+
+
+/*
+ * benchFile - Assembles a source file a num of times and prints its benchmark line.
+ * @name: Name of the source file.
+ * @repeats: The num of times the file is assembled.
+ * @total_lines: Increased by the num of lines assembled.
+ * @total_time: Increased by the time it took.
+ *
+ * Return: 1 on success, 0 if the file couldn't be read or assembled.
+ */
+static int benchFile(const char *name, int repeats, double *total_lines, double *total_time)
+{
+	double *times = (double *) malloc(repeats * sizeof(double));
+	double sum = 0;
+	long size, lines;
+	char *text = readFile(name, &size);
+	asm_result result;
+	int words = 0;
+	int i;
+
+	if (text == NULL || times == NULL) {
+		fprintf(stderr, "bench: unable to read \"%s\".\n", name);
+		free(text);
+		free(times);
+		return 0;
+	}
+	lines = countLines(text, size);
+
+	for (i = 0; i < repeats; i++) {
+		double start = now();
+		int assemble_err = assembleNamed(name, text, size, &result);
+
+		times[i] = now() - start;
+		sum += times[i];
+		words = result.IC + result.DC;
+		if (assemble_err != 1) {
+			fprintf(stderr, "bench: \"%s\" doesn't assemble:\n%s", name, result.diagnostics);
+			freeAsmResult(&result);
+			free(text);
+			free(times);
+			return 0;
+		}
+		freeAsmResult(&result);
+	}
+
+	qsort(times, repeats, sizeof(double), compareTimes);
+	printf("%-24s %7ld %6d %12.0f %9.3f %9.3f %9.3f %9.3f\n", name, lines, words, lines * repeats / sum,
+		times[0] * 1e3, times[repeats / 2] * 1e3, times[(repeats * 99) / 100] * 1e3, times[repeats - 1] * 1e3);
+
+	*total_lines += (double) lines * repeats;
+	*total_time += sum;
+	free(text);
+	free(times);
+	return 1;
+}
+
+
+int main(int argc, char *argv[])
+{
+	int repeats = DEFAULT_REPEATS;
+	double total_lines = 0, total_time = 0;
+	int first_file = 1;
+	int i;
+
+	if (argc > 2 && strcmp(argv[1], "-r") == 0) {
+		repeats = atoi(argv[2]);
+		first_file = 3;
+	}
+	if (repeats < 1 || first_file >= argc) {
+		fprintf(stderr, "usage: bench [-r repeats] file.as...\n");
+		return 1;
+	}
+
+	printf("%-24s %7s %6s %12s %9s %9s %9s %9s\n", "file", "lines", "words", "lines/sec", "min ms", "p50 ms", "p99 ms", "max ms");
+	for (i = first_file; i < argc; i++) {
+		if (benchFile(argv[i], repeats, &total_lines, &total_time) == 0) {
+			return 1;
+		}
+	}
+	printf("total: %.0f lines in %.3f s, %.0f lines/sec (%d runs of every file)\n",
+		total_lines, total_time, total_lines / total_time, repeats);
+	return 0;
+}
@@ -0,0 +1,295 @@
+/*
+ * gen_bench.c - Generator of large synthetic source files for the benchmark ("make bench").
+ * Every workload is a valid program that fills the memory image up to its limit (MEMORY_SIZE),
+ * stressing a different part of the assembler: the label table, macro expansion, the data image
+ * or the external labels.
+ * The programs are generated by a fixed pseudo-random sequence, so a workload and a seed always
+ * give the same file.
+ *
+ * usage: gen_bench <workload> [seed] > file.as
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#define WORD_BUDGET (4096 - 100 - 8) /* num of memory words a program may take, a little under the limit */
+#define MAX_MACROS 64
+#define MAX_MACRO_LINES 12
+
+/* the kinds of an operand */
+#define OP_IMMEDIATE 0
+#define OP_DIRECT 1 /* a label or an external label */
+#define OP_INDIRECT 2
+#define OP_REGISTER 3
+
+/* this struct defines a workload, all the rates are percents of the lines */
+typedef struct {
+	char *name;
+	int num_of_labels; /* labels that are defined in the program */
+	int label_rate; /* lines that define a label */
+	int macro_rate; /* lines that call a macro */
+	int num_of_macros;
+	int string_rate; /* .string lines */
+	int data_rate; /* .data lines */
+	int num_of_externs;
+	int extern_rate; /* label operands that are external labels */
+	int entry_rate; /* labels that are also ".entry" */
+} workload;
+
+static workload workloads[] = {
+	{"memory", 400, 20, 5, 8, 5, 10, 16, 20, 5},
+	{"labels", 3000, 95, 0, 0, 0, 40, 8, 5, 10},
+	{"macros", 200, 10, 60, 48, 2, 3, 8, 10, 5},
+	{"strings", 300, 30, 0, 0, 60, 10, 8, 10, 5},
+	{"externs", 300, 20, 0, 0, 5, 5, 600, 70, 5}
+};
+
+/* this struct defines an instruction: its name and the kinds its operands may be (-1 when there's no operand) */
+typedef struct {
+	char *name;
+	int num_of_operands;
+	int source[4];
+	int target[4];
+} instruction;
+
+static instruction instructions[] = {
+	{"mov", 2, {OP_IMMEDIATE, OP_DIRECT, OP_INDIRECT, OP_REGISTER}, {OP_DIRECT, OP_INDIRECT, OP_REGISTER, -1}},
+	{"cmp", 2, {OP_IMMEDIATE, OP_DIRECT, OP_INDIRECT, OP_REGISTER}, {OP_IMMEDIATE, OP_DIRECT, OP_INDIRECT, OP_REGISTER}},
+	{"add", 2, {OP_IMMEDIATE, OP_DIRECT, OP_INDIRECT, OP_REGISTER}, {OP_DIRECT, OP_INDIRECT, OP_REGISTER, -1}},
+	{"sub", 2, {OP_IMMEDIATE, OP_DIRECT, OP_INDIRECT, OP_REGISTER}, {OP_DIRECT, OP_INDIRECT, OP_REGISTER, -1}},
+	{"lea", 2, {OP_DIRECT, -1, -1, -1}, {OP_DIRECT, OP_INDIRECT, OP_REGISTER, -1}},
+	{"clr", 1, {-1, -1, -1, -1}, {OP_DIRECT, OP_INDIRECT, OP_REGISTER, -1}},
+	{"not", 1, {-1, -1, -1, -1}, {OP_DIRECT, OP_INDIRECT, OP_REGISTER, -1}},
+	{"inc", 1, {-1, -1, -1, -1}, {OP_DIRECT, OP_INDIRECT, OP_REGISTER, -1}},
+	{"dec", 1, {-1, -1, -1, -1}, {OP_DIRECT, OP_INDIRECT, OP_REGISTER, -1}},
+	{"jmp", 1, {-1, -1, -1, -1}, {OP_DIRECT, OP_INDIRECT, -1, -1}},
+	{"bne", 1, {-1, -1, -1, -1}, {OP_DIRECT, OP_INDIRECT, -1, -1}},
+	{"red", 1, {-1, -1, -1, -1}, {OP_DIRECT, OP_INDIRECT, OP_REGISTER, -1}},
+	{"prn", 1, {-1, -1, -1, -1}, {OP_IMMEDIATE, OP_DIRECT, OP_INDIRECT, OP_REGISTER}},
+	{"jsr", 1, {-1, -1, -1, -1}, {OP_DIRECT, OP_INDIRECT, -1, -1}},
+	{"rts", 0, {-1, -1, -1, -1}, {-1, -1, -1, -1}},
+	{"stop", 0, {-1, -1, -1, -1}, {-1, -1, -1, -1}}
+};
+
+static workload *w;
+static unsigned long seed_state;
+static int labels_defined = 0;
+
+
+/*
+ * nextRandom - Returns the next number of the pseudo-random sequence (a linear congruential generator).
+ * @n: The range of the number.
+ *
+ * Return: A number between 0 and n - 1.
+ */
+static int nextRandom(int n)
+{
+	seed_state = (seed_state * 1103515245UL + 12345UL) & 0x7fffffffUL;
+	return (int) ((seed_state >> 8) % n);
+}
+
+
+/*
+ * chooseKind - Chooses one of the kinds an operand may be.
+ * @kinds: The kinds, -1 terminated (up to 4).
+ *
+ * Return: The chosen kind.
+ */
+static int chooseKind(int *kinds)
+{
+	int count = 0;
+	while (count < 4 && kinds[count] != -1) {
+		count++;
+	}
+	return kinds[nextRandom(count)];
+}
+
+
+/*
+ * writeOperand - Writes an operand of a given kind.
+ * @out: The buffer to be filled.
+ * @kind: The kind of the operand.
+ *
+ * Return: The num of characters written.
+ */
+static int writeOperand(char *out, int kind)
+{
+	switch (kind) {
+		case OP_IMMEDIATE:
+			return sprintf(out, "#%d", nextRandom(201) - 100);
+		case OP_INDIRECT:
+			return sprintf(out, "*r%d", nextRandom(8));
+		case OP_REGISTER:
+			return sprintf(out, "r%d", nextRandom(8));
+		default:
+			if (w -> num_of_externs > 0 && nextRandom(100) < w -> extern_rate) {
+				return sprintf(out, "X%d", nextRandom(w -> num_of_externs));
+			}
+			return sprintf(out, "L%d", nextRandom(w -> num_of_labels)); /* may be defined later */
+	}
+}
+
+
+/*
+ * writeInstruction - Writes a random instruction (without a label).
+ * @out: The buffer to be filled, a single line with its '\n'.
+ *
+ * Return: The num of memory words the instruction takes.
+ */
+static int writeInstruction(char *out)
+{
+	instruction *ins = &instructions[nextRandom(16)];
+	int source = -1, target = -1;
+
+	out += sprintf(out, "\t%s", ins -> name);
+	if (ins -> num_of_operands == 2) {
+		source = chooseKind(ins -> source);
+		*out++ = ' ';
+		out += writeOperand(out, source);
+		*out++ = ',';
+		*out++ = ' ';
+	}
+	if (ins -> num_of_operands >= 1) {
+		target = chooseKind(ins -> target);
+		if (ins -> num_of_operands == 1) {
+			*out++ = ' ';
+		}
+		out += writeOperand(out, target);
+	}
+	strcpy(out, "\n");
+
+	/* two register operands share a single word */
+	if ((source == OP_INDIRECT || source == OP_REGISTER) && (target == OP_INDIRECT || target == OP_REGISTER)) {
+		return 2;
+	}
+	return 1 + ins -> num_of_operands;
+}
+
+
+/*
+ * writeData - Writes a random .string or .data directive (without a label).
+ * @out: The buffer to be filled, a single line with its '\n'.
+ * @is_string: 1 for a .string directive, 0 for a .data directive.
+ * @max_words: The most memory words the directive may take.
+ *
+ * Return: The num of memory words the directive takes.
+ */
+static int writeData(char *out, int is_string, int max_words)
+{
+	int words, i;
+
+	if (is_string) {
+		words = 1 + nextRandom(50);
+		if (words > max_words - 1) {
+			words = max_words - 1;
+		}
+		out += sprintf(out, "\t.string \"");
+		for (i = 0; i < words; i++) {
+			*out++ = 'a' + nextRandom(26);
+		}
+		strcpy(out, "\"\n");
+		return words + 1; /* with the null character */
+	}
+
+	words = 1 + nextRandom(8);
+	if (words > max_words) {
+		words = max_words;
+	}
+	out += sprintf(out, "\t.data %d", nextRandom(2001) - 1000);
+	for (i = 1; i < words; i++) {
+		out += sprintf(out, ", %d", nextRandom(2001) - 1000);
+	}
+	strcpy(out, "\n");
+	return words;
+}
+
+
+int main(int argc, char *argv[])
+{
+	int macro_words[MAX_MACROS];
+	char line[128];
+	int words_left = WORD_BUDGET;
+	int num_of_workloads = sizeof(workloads) / sizeof(workloads[0]);
+	int i, j;
+
+	if (argc < 2) {
+		fprintf(stderr, "usage: gen_bench <workload> [seed] > file.as\n");
+		return 1;
+	}
+	w = NULL;
+	for (i = 0; i < num_of_workloads; i++) {
+		if (strcmp(argv[1], workloads[i].name) == 0) {
+			w = &workloads[i];
+		}
+	}
+	if (w == NULL) {
+		fprintf(stderr, "gen_bench: unknown workload \"%s\", the workloads are:", argv[1]);
+		for (i = 0; i < num_of_workloads; i++) {
+			fprintf(stderr, " %s", workloads[i].name);
+		}
+		fprintf(stderr, "\n");
+		return 1;
+	}
+	seed_state = (argc > 2) ? strtoul(argv[2], NULL, 10) : 1;
+
+	/* the external labels */
+	for (i = 0; i < w -> num_of_externs; i++) {
+		printf(".extern X%d\n", i);
+	}
+
+	/* the macros, every one is a few instructions */
+	for (i = 0; i < w -> num_of_macros; i++) {
+		int num_of_lines = 2 + nextRandom(MAX_MACRO_LINES - 1);
+		printf("macr M%d\n", i);
+		macro_words[i] = 0;
+		for (j = 0; j < num_of_lines; j++) {
+			macro_words[i] += writeInstruction(line);
+			fputs(line, stdout);
+		}
+		printf("endmacr\n");
+	}
+
+	/* the body: every label that isn't defined yet keeps a word for itself at the end */
+	while (words_left > (w -> num_of_labels - labels_defined) + 60)
+	{
+		int kind = nextRandom(100);
+		int words;
+
+		if (kind < w -> macro_rate) {
+			i = nextRandom(w -> num_of_macros);
+			printf("\tM%d\n", i);
+			words_left -= macro_words[i];
+			continue; /* a macro call can't define a label */
+		}
+
+		if (kind < w -> macro_rate + w -> string_rate) {
+			words = writeData(line, 1, 60);
+		} else if (kind < w -> macro_rate + w -> string_rate + w -> data_rate) {
+			words = writeData(line, 0, 60);
+		} else {
+			words = writeInstruction(line);
+		}
+
+		if (labels_defined < w -> num_of_labels && nextRandom(100) < w -> label_rate) {
+			printf("L%d:", labels_defined++);
+		}
+		fputs(line, stdout);
+		words_left -= words;
+	}
+
+	/* the labels that are still not defined */
+	while (labels_defined < w -> num_of_labels) {
+		printf("L%d:\trts\n", labels_defined++);
+	}
+
+	/* the entry labels */
+	for (i = 0; i < w -> num_of_labels; i++) {
+		if (nextRandom(100) < w -> entry_rate) {
+			printf(".entry L%d\n", i);
+		}
+	}
+
+	return 0;
+}
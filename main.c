@@ -1,139 +1,669 @@
 /*
  * main.c - Main file for the assembler project
  * This file contains the main function which drives the assembler program.
- * The assembler program takes multiple input files, processes them through a pre-assembler, 
+ * The assembler program takes multiple input files, processes them through a pre-assembler,
  * and then runs two stages of the assembler to produce the final output files.
+ * The files are independent of each other, so with "-j N" they are assembled by N worker threads,
+ * while the output of every file is still printed in the order of the command line.
+ * With "--link", the files are then linked in memory into a single image.
  */
 
+#include <pthread.h>
+#include <limits.h>
 #include "data.h"
 #include "pre_processing/pre_assembler.h"
 #include "pre_processing/macros_table.h"
 #include "assembler/assembler.h"
 #include "assembler/excess_macro_list.h"
+#include "watch.h"
 
-/* 
+/* this struct defines a single input file, assembled by one of the workers */
+typedef struct {
+	char *name; /* name of the file, without ".as" */
+	int index; /* index of the file in the command line */
+	asm_context *ctx; /* the context of the file, kept until its diagnostics are printed */
+	int result; /* FILE_UNREADABLE, FILE_DONE, FILE_FATAL, FILE_CACHED or FILE_ERRORS */
+	int done;
+} file_job;
+
+/* the jobs shared by all the workers */
+static file_job *jobs;
+static int next_job = 0; /* the next job no worker has taken yet */
+static int stop_jobs = 0; /* turned on after a fatal error, no new jobs are taken */
+static pthread_mutex_t jobs_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t job_done = PTHREAD_COND_INITIALIZER;
+
+/* the build cache summary */
+static int cache_hits = 0;
+static int cache_misses = 0;
+
+/* the modules kept for the linker ("--link"), indexed by the index of the file in the command line */
+static link_module *modules = NULL;
+static int num_of_modules = 0;
+static int files_done = 0; /* the files that were assembled successfully */
+
+
+/*
+ * assembleFile - Assembles a single input file in the current context.
+ * @file_name: Name of the input file, without ".as".
+ * @num_of_file: Index of the file in the command line.
+ *
+ * Return: FILE_UNREADABLE, FILE_DONE, FILE_FATAL, FILE_CACHED or FILE_ERRORS.
+ */
+static int assembleFile(char *file_name, int num_of_file)
+{
+	int pre_assemblerErrorType;
+	int first_stageErrorType;
+	int second_stageErrorType;
+	char src_filename[256 + 4];
+	char cache_key[CACHE_KEY_SIZE + 1] = "";
+	int file_name_length = strlen(file_name);
+	FILE *fd;
+
+	memset(&Ctx -> stats, 0, sizeof(asm_stats));
+	Ctx -> file_name = file_name;
+	Ctx -> error_count = 0;
+	Ctx -> errors_capped = 0;
+
+	/* check in case the input files are too long */
+	if (file_name_length >= 256) {
+		diagPrintf(DIAG_FILE_NAME, 0, "\nERROR: in file \"%s\", the file name is too long.\n", file_name);
+		return FILE_FATAL;
+	}
+
+	/* open the i'th file, store in a pointer ("-" is stdin) */
+	if (OUTPUT_STREAM == 1) {
+		strcpy(src_filename, file_name);
+		fd = stdin;
+	} else {
+		sprintf(src_filename, "%s.as", file_name);
+		fd = fopen(src_filename, "r");
+	}
+	if (fd == NULL) {
+		diagPrintf(DIAG_FILE_UNREADABLE, 0, "ERROR: Unable to open file: \"%s\".\n", file_name);
+		return FILE_UNREADABLE;
+	}
+
+	/* --(look for the output files in the build cache)-- */
+	if (USE_CACHE == 1)
+	{
+		int key_err = cacheKey(fd, cache_key);
+		if (key_err == 2) {
+			diagPrintf(DIAG_NO_MEMORY, 0, "\nMEMORY ERROR in build cache of file \"%s\". Exiting program.\n", src_filename);
+			fclose(fd);
+			return FILE_FATAL;
+		}
+		/* the expanded source isn't cached, so it's assembled again with "--emit-am", and so is a module of the linker */
+		if (key_err == 1 && EMIT_AM == 0 && modules == NULL && replayCache(cache_key, file_name) == 1) {
+			logPrintf("Assembler of file \"%s\" is up to date (build cache).\n\n", file_name);
+			fclose(fd);
+			return FILE_CACHED;
+		}
+	}
+
+	/* --(Run the pre-assembler)-- */
+	STAT_BEGIN(STAGE_PRE_ASSEMBLER);
+	pre_assemblerErrorType = pre_assembler(fd, num_of_file, file_name);
+	STAT_END(STAGE_PRE_ASSEMBLER);
+
+	if (pre_assemblerErrorType == 0)
+	{
+		/* in case pre-assembler failed */
+		diagPrintf(DIAG_FILE_FAILED, 0, "\nERROR in pre-assembler of file \"%s\". moving to next file.\n", src_filename);
+		MAIN_CLEANUP_AND_CONTINUE;
+		return FILE_ERRORS;
+	}
+	else if (pre_assemblerErrorType == 2)
+	{
+		/* in case pre-assembler failed due to memory error */
+		diagPrintf(DIAG_NO_MEMORY, 0, "\nMEMORY ERROR in pre-assembler of file \"%s\". Exiting program.\n", src_filename);
+		MAIN_CLEAN_BEFORE_EXIT;
+		return FILE_FATAL;
+	}
+
+	/* AT THIS POINT THE expanded source has been created succesfully */
+	logPrintf("Pre-assembler of file \"%s\" is finished successfully.\n", file_name);
+
+	/* --(run the first stage of the assembler)-- */
+	STAT_BEGIN(STAGE_FIRST);
+	first_stageErrorType = first_stage(file_name);
+	STAT_END(STAGE_FIRST);
+	if (first_stageErrorType == 0)
+	{
+		/* invalid regular error */
+		diagPrintf(DIAG_FILE_FAILED, 0, "\nERROR in assembler of file \"%s\". moving to next file.\n", src_filename);
+		MAIN_CLEANUP_AND_CONTINUE;
+		return FILE_ERRORS;
+	}
+	else if (first_stageErrorType == 2)
+	{
+		/* memory error */
+		diagPrintf(DIAG_NO_MEMORY, 0, "\nMEMORY ERROR in assembler of file \"%s\". Exiting program.\n", src_filename);
+		MAIN_CLEAN_BEFORE_EXIT;
+		return FILE_FATAL;
+	}
+
+	/* --(run the second stage of the assembler)--  */
+	STAT_BEGIN(STAGE_SECOND);
+	second_stageErrorType = second_stage(file_name);
+	STAT_END(STAGE_SECOND);
+
+	/* --(run the final stage of the assembler)--  */
+	STAT_BEGIN(STAGE_OUTPUT);
+	if (second_stageErrorType == 1) {
+		second_stageErrorType = createOutput(file_name); /* 0 - the files can't be created, 2 - memory error */
+	}
+	STAT_END(STAGE_OUTPUT);
+	if (second_stageErrorType == 0)
+	{
+		/* invalid regular error */
+		diagPrintf(DIAG_FILE_FAILED, 0, "\nERROR in assembler of file \"%s\". moving to next file.\n", src_filename);
+		MAIN_CLEANUP_AND_CONTINUE;
+		return FILE_ERRORS;
+	}
+	else if (second_stageErrorType == 2)
+	{
+		/* memory error */
+		diagPrintf(DIAG_NO_MEMORY, 0, "\nMEMORY ERROR in assembler of file \"%s\". Exiting program.\n", src_filename);
+		MAIN_CLEAN_BEFORE_EXIT;
+		return FILE_FATAL;
+	}
+
+	/* keep the output of the file for the linker */
+	if (modules != NULL && keepModule(&modules[num_of_file], file_name) == 0) {
+		diagPrintf(DIAG_NO_MEMORY, 0, "\nMEMORY ERROR in linker of file \"%s\". Exiting program.\n", src_filename);
+		MAIN_CLEAN_BEFORE_EXIT;
+		return FILE_FATAL;
+	}
+
+	/* AT THIS POINT THE output files have been created succesfully */
+	logPrintf("\nAssembler of file \"%s\" is finished successfully.\n", file_name);
+
+	if (USE_CACHE == 1 && cache_key[0] != '\0' && OUTPUT_FILES == 1) {
+		storeCache(cache_key, file_name);
+	}
+
+	logPrintf("\n"); /* new line before the next file*/
+
+	/* free the tables of the current file */
+	MAIN_CLEANUP_AND_CONTINUE;
+	return FILE_DONE;
+}
+
+
+/*
+ * worker - Takes the next file from the jobs and assembles it, until no jobs are left.
+ * @arg: Unused.
+ *
+ * Every file is assembled in a context of its own, with its diagnostics buffered in the context
+ * until the main thread prints them.
+ *
+ * Return: NULL.
+ */
+static void *worker(void *arg)
+{
+	while (1)
+	{
+		file_job *job;
+		asm_context *ctx;
+
+		/* take the next job */
+		pthread_mutex_lock(&jobs_lock);
+		if (stop_jobs == 1 || next_job == NUM_OF_FILES) {
+			pthread_mutex_unlock(&jobs_lock);
+			break;
+		}
+		job = &jobs[next_job++];
+		pthread_mutex_unlock(&jobs_lock);
+
+		ctx = newContext(1);
+		if (ctx == NULL) {
+			printf("\nMEMORY ERROR in assembler of file \"%s.as\". Exiting program.\n", job -> name);
+			job -> result = FILE_FATAL;
+		} else {
+			Ctx = ctx;
+			job -> result = assembleFile(job -> name, job -> index);
+			Ctx = NULL;
+		}
+
+		/* hand the context over to the main thread */
+		pthread_mutex_lock(&jobs_lock);
+		job -> ctx = ctx;
+		job -> done = 1;
+		if (job -> result == FILE_FATAL) {
+			stop_jobs = 1;
+		}
+		pthread_cond_broadcast(&job_done);
+		pthread_mutex_unlock(&jobs_lock);
+	}
+	return NULL;
+}
+
+
+/*
+ * runJobs - Assembles all the input files by a pool of worker threads.
+ * @num_of_workers: The num of worker threads.
+ *
+ * The diagnostics of every file are printed once the file is done, in the order of the command line.
+ * After a fatal error, the files that come after it are not printed (as if they were never assembled).
+ *
+ * Return: The num of unreadable files, -1 on a fatal error.
+ */
+static int runJobs(int num_of_workers)
+{
+	pthread_t *workers = (pthread_t *) malloc(num_of_workers * sizeof(pthread_t));
+	int file_error_count = 0;
+	int fatal = 0;
+	int started = 0;
+	int i;
+
+	if (workers == NULL) {
+		printf("\nMEMORY ERROR: unable to create the worker threads. Exiting program.\n");
+		return -1;
+	}
+
+	for (i = 0; i < num_of_workers; i++) {
+		if (pthread_create(&workers[i], NULL, worker, NULL) != 0) {
+			break; /* keep going with the workers that were created */
+		}
+		started++;
+	}
+	if (started == 0) {
+		worker(NULL); /* no threads at all, do the work here */
+	}
+
+	/* print the files in order, each one as soon as it is done */
+	for (i = 0; i < NUM_OF_FILES && fatal == 0; i++)
+	{
+		pthread_mutex_lock(&jobs_lock);
+		while (jobs[i].done == 0 && !(stop_jobs == 1 && i >= next_job)) {
+			pthread_cond_wait(&job_done, &jobs_lock);
+		}
+		pthread_mutex_unlock(&jobs_lock);
+
+		if (jobs[i].done == 0) {
+			break; /* never taken, there was a fatal error */
+		}
+		if (jobs[i].ctx != NULL) {
+			flushLog(jobs[i].ctx);
+			if (STATS_FORMAT != STATS_OFF && jobs[i].result != FILE_UNREADABLE && jobs[i].result != FILE_FATAL) {
+				printFileStats(jobs[i].name, &jobs[i].ctx -> stats);
+			}
+		}
+		if (jobs[i].result == FILE_UNREADABLE) {
+			file_error_count++;
+		}
+		else if (jobs[i].result == FILE_FATAL) {
+			fatal = 1;
+		}
+		else if (jobs[i].result == FILE_CACHED) {
+			cache_hits++;
+		}
+		else {
+			cache_misses++;
+			files_done += (jobs[i].result == FILE_DONE);
+		}
+	}
+
+	for (i = 0; i < started; i++) {
+		pthread_join(workers[i], NULL);
+	}
+	for (i = 0; i < NUM_OF_FILES; i++) {
+		freeContext(jobs[i].ctx);
+	}
+	free(workers);
+
+	return (fatal == 1) ? -1 : file_error_count;
+}
+
+
+/*
+ * freeModules - Frees the modules kept for the linker.
+ */
+static void freeModules()
+{
+	int i;
+	for (i = 0; i < num_of_modules; i++) {
+		freeModule(&modules[i]);
+	}
+	free(modules);
+	modules = NULL;
+}
+
+
+/*
+ * linkFiles - Links all the input files into a single image ("--link").
+ * @link_name: The name of the linked image.
+ *
+ * The files are linked only when every one of them was assembled successfully.
+ * The diagnostics of the link are kept in a context of their own, the same way the diagnostics of
+ * every file are, and are printed once the link is done.
+ *
+ * Return: 1 on success, 0 on error.
+ */
+static int linkFiles(char *link_name)
+{
+	asm_context *ctx;
+	int link_err;
+
+	ctx = newContext(1);
+	if (ctx == NULL) {
+		printf("\nMEMORY ERROR: unable to create the linker context. Exiting program.\n");
+		freeModules();
+		return 0;
+	}
+	Ctx = ctx;
+	ctx -> file_name = link_name;
+
+	if (files_done != NUM_OF_FILES) {
+		diagPrintf(DIAG_LINK_FILES, 0, "\nERROR: the files aren't linked into \"%s\", not all of them were assembled successfully.\n", link_name);
+		link_err = 0;
+	}
+	else {
+		link_err = linkModules(modules, num_of_modules, link_name);
+		if (link_err == 0) {
+			diagPrintf(DIAG_FILE_FAILED, 0, "\nERROR in linker of \"%s\".\n", link_name);
+		}
+		else if (link_err == 2) {
+			diagPrintf(DIAG_NO_MEMORY, 0, "\nMEMORY ERROR in linker of \"%s\". Exiting program.\n", link_name);
+		}
+		else {
+			logPrintf("Linker of \"%s\" is finished successfully.\n\n", link_name);
+		}
+	}
+	freeModules();
+
+	flushLog(ctx);
+	freeContext(ctx);
+	Ctx = NULL;
+	return (link_err == 1);
+}
+
+
+/*
  * main - Main function for the assembler program.
  * @argc: Number of command line arguments.
- * @argv: Array of command line arguments, each representing an input file name.
- * 
- * The function processes each input file through the pre-assembler, first stage, 
- * and second stage of the assembler. If any errors occur during processing, they 
+ * @argv: Array of command line arguments, each representing an input file name or an option.
+ *
+ * The function processes each input file through the pre-assembler, first stage,
+ * and second stage of the assembler. If any errors occur during processing, they
  * are reported, and the program moves on to the next file.
- * 
+ * An input file "-" is the stream mode: the source is read from stdin, and the output files are written to
+ * stdout as a single stream (see "createStreamOutput"), with the diagnostics on stderr.
+ * Options:
+ *   --emit-am   write the expanded source of every file to "pre_processing/<name>.am" (debug).
+ *   -j N        assemble up to N files at the same time (default: 1).
+ *   --format=F  the format of the output files: "text" for .ob, .ent and .ext (default),
+ *               "bin" for a single binary object file "output/<name>.bin".
+ *   --stats     print the time of every stage and the counters of every file to stderr, and their sum
+ *               (--stats=json for JSON lines), only when built with "make STATS=1".
+ *   --cache     copy the output files of an unchanged source from the build cache ("cache/"),
+ *               instead of assembling it again.
+ *   --watch     keep running, and assemble again every file whose source changes (until Ctrl-C).
+ *   --socket=P  (implies --watch) also assemble the files that clients of the local socket P ask for,
+ *               the input files may then be left out.
+ *   --mem-words=N  the num of words in memory (default: 4096), the program is still loaded at address 100.
+ *   --stage-threads=N  split the first stage of a large file into up to N chunks, processed by N threads.
+ *   --link=NAME once all the files are assembled successfully, link them into a single image "output/NAME.ob"
+ *               (and ".ent", or ".bin"): the externs of every file are resolved by the entries of the others.
+ *   --link-only (with --link) write only the linked image, without the output files of every file.
+ *   --diagnostics=F  the format of the diagnostics of every file: "text" (default), or "json" for a JSON
+ *               object (file, line, severity, code, message) per diagnostic, one per line.
+ *   --max-errors N  stop a file, or the link, after N errors, instead of reading the rest of it (default: no limit).
+ *
  * Return: 1 on success, 0 on error.
  */
-int main(int argc, char *argv[]) 
-{ 
+int main(int argc, char *argv[])
+{
 	int i, file_error_count = 0;
-	
+	int num_of_workers = 1;
+	int watch = 0;
+	char *socket_path = NULL;
+	char *link_name = NULL;
+	double run_start = 0;
+
+	jobs = (file_job *) calloc(argc, sizeof(file_job));
+	if (jobs == NULL) {
+		printf("\nMEMORY ERROR: unable to read the input files. Exiting program.\n");
+		return 0;
+	}
+
+	/* --(read the command line options)-- */
+	NUM_OF_FILES = 0;
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-j") == 0) {
+			char *end;
+			num_of_workers = (i + 1 < argc) ? (int) strtol(argv[i + 1], &end, 10) : 0;
+			if (i + 1 == argc || *argv[i + 1] == '\0' || *end != '\0' || num_of_workers < 1) {
+				printf("\nERROR: option \"-j\" must be followed by a positive num of jobs.\n");
+				free(jobs);
+				return 0;
+			}
+			i++; /* skip the num of jobs */
+		}
+		else if (strcmp(argv[i], "--max-errors") == 0) {
+			char *end;
+			long errors = (i + 1 < argc) ? strtol(argv[i + 1], &end, 10) : 0;
+			if (i + 1 == argc || *argv[i + 1] == '\0' || *end != '\0' || errors < 1 || errors > INT_MAX) {
+				printf("\nERROR: option \"--max-errors\" must be followed by a positive num of errors.\n");
+				free(jobs);
+				return 0;
+			}
+			MAX_ERRORS = (int) errors;
+			i++; /* skip the num of errors */
+		}
+		else if (strcmp(argv[i], "-") == 0) {
+			/* the source is read from stdin, and the output files are written to stdout */
+			OUTPUT_STREAM = 1;
+			DIAG_STDERR = 1;
+			jobs[NUM_OF_FILES].name = argv[i];
+			jobs[NUM_OF_FILES].index = i;
+			NUM_OF_FILES++;
+		}
+		else if (strncmp(argv[i], "--", 2) != 0) {
+			/* an input file */
+			jobs[NUM_OF_FILES].name = argv[i];
+			jobs[NUM_OF_FILES].index = i;
+			NUM_OF_FILES++;
+		}
+		else if (strcmp(argv[i], "--emit-am") == 0) {
+			EMIT_AM = 1;
+		}
+		else if (strcmp(argv[i], "--stats") == 0 || strcmp(argv[i], "--stats=text") == 0 || strcmp(argv[i], "--stats=json") == 0) {
+#ifdef ASM_STATS
+			STATS_FORMAT = (strcmp(argv[i], "--stats=json") == 0) ? STATS_JSON : STATS_TEXT;
+#else
+			printf("\nERROR: option \"%s\" needs an assembler that was built with \"make STATS=1\".\n", argv[i]);
+			free(jobs);
+			return 0;
+#endif
+		}
+		else if (strcmp(argv[i], "--cache") == 0) {
+			USE_CACHE = 1;
+		}
+		else if (strncmp(argv[i], "--mem-words=", 12) == 0) {
+			char *end;
+			long words = strtol(argv[i] + 12, &end, 10);
+			if (argv[i][12] == '\0' || *end != '\0' || words <= FIRST_ADDRESS || words > MAX_MEMORY_WORDS) {
+				printf("\nERROR: option \"--mem-words\" must be a num of words between %d and %d.\n", FIRST_ADDRESS + 1, MAX_MEMORY_WORDS);
+				free(jobs);
+				return 0;
+			}
+			MEMORY_WORDS = (int) words;
+		}
+		else if (strncmp(argv[i], "--stage-threads=", 16) == 0) {
+			char *end;
+			long threads = strtol(argv[i] + 16, &end, 10);
+			if (argv[i][16] == '\0' || *end != '\0' || threads < 1 || threads > 256) {
+				printf("\nERROR: option \"--stage-threads\" must be a num of threads between 1 and 256.\n");
+				free(jobs);
+				return 0;
+			}
+			STAGE_THREADS = (int) threads;
+		}
+		else if (strcmp(argv[i], "--watch") == 0) {
+			watch = 1;
+		}
+		else if (strncmp(argv[i], "--socket=", 9) == 0 && argv[i][9] != '\0') {
+			watch = 1;
+			socket_path = argv[i] + 9;
+		}
+		else if (strncmp(argv[i], "--link=", 7) == 0 && argv[i][7] != '\0') {
+			link_name = argv[i] + 7;
+		}
+		else if (strcmp(argv[i], "--link-only") == 0) {
+			OUTPUT_FILES = 0;
+		}
+		else if (strcmp(argv[i], "--format=text") == 0) {
+			OUTPUT_FORMAT = FORMAT_TEXT;
+		}
+		else if (strcmp(argv[i], "--format=bin") == 0) {
+			OUTPUT_FORMAT = FORMAT_BIN;
+		}
+		else if (strcmp(argv[i], "--diagnostics=text") == 0) {
+			DIAG_FORMAT = DIAG_TEXT;
+		}
+		else if (strcmp(argv[i], "--diagnostics=json") == 0) {
+			DIAG_FORMAT = DIAG_JSON;
+		}
+		else {
+			printf("\nERROR: unknown option \"%s\".\n", argv[i]);
+			free(jobs);
+			return 0;
+		}
+	}
+
 	/* in case there are no input files */
-	if (argc == 1) {
+	if (NUM_OF_FILES == 0 && socket_path == NULL) {
 		printf("\nERROR: You must enter input files.\n");
+		free(jobs);
 		return 0;;
-	} else {
-		NUM_OF_FILES = argc-1;
 	}
 
+	/* the linker links the files of a single run */
+	if (link_name == NULL && OUTPUT_FILES == 0) {
+		printf("\nERROR: option \"--link-only\" can't be used without \"--link\".\n");
+		free(jobs);
+		return 0;
+	}
+	if (link_name != NULL && watch == 1) {
+		printf("\nERROR: option \"--link\" can't be used with \"--watch\".\n");
+		free(jobs);
+		return 0;
+	}
 
-	/* --(scrolling between input files)-- */
-	for (i = 1; i < argc; i++) 
-	{
-		int pre_assemblerErrorType;
-		int first_stageErrorType;
-		int second_stageErrorType;
-		char src_filename[256];	
-		int file_name_length = strlen(argv[i]);
-		FILE *fd;
-
-		/* check in case the input files are too long */
-		if (file_name_length >= 256) { 
-			printf("\nERROR: in file \"%s\", the file name is too long.\n", argv[i]);
+	/* the stream mode writes no files at all */
+	if (OUTPUT_STREAM == 1 && (NUM_OF_FILES > 1 || watch == 1 || link_name != NULL || USE_CACHE == 1 || EMIT_AM == 1)) {
+		printf("\nERROR: input \"-\" must be the only input file, and can't be used with \"--watch\", \"--link\", \"--cache\" or \"--emit-am\".\n");
+		free(jobs);
+		return 0;
+	}
+	if (link_name != NULL) {
+		num_of_modules = argc;
+		modules = (link_module *) calloc(num_of_modules, sizeof(link_module));
+		if (modules == NULL) {
+			printf("\nMEMORY ERROR: unable to create the linker. Exiting program.\n");
+			free(jobs);
 			return 0;
-		}	
+		}
+	}
 
-		/* open the i'th file, store in a pointer */
-		sprintf(src_filename, "%s.as", argv[i]);
+	if (STATS_FORMAT != STATS_OFF) {
+		run_start = statsClock();
+	}
 
-		fd = fopen(src_filename, "r"); 
-		if (fd == NULL) {
-			printf("ERROR: Unable to open file: \"%s\".\n", argv[i]);
-			file_error_count++;
-			continue;
-		}		
-		
-		/* --(Run the pre-assembler)-- */
-		pre_assemblerErrorType = pre_assembler(fd, i, argv[i]);
-		
-		if (pre_assemblerErrorType == 0) 
-		{
-			/* in case pre-assembler failed */
-			char filename[256];			
-			sprintf(filename, "%s.am", argv[i]);
+	if (watch == 1)
+	{
+		/* --(assemble the input files whenever they change)-- */
+		char **names = (char **) malloc((NUM_OF_FILES + 1) * sizeof(char *));
+		int watch_ok;
 
-			printf("\nERROR in pre-assembler of file \"%s\". moving to next file.\n", src_filename);
-			MAIN_CLEANUP_AND_CONTINUE;
-			continue;
-		}
-		else if (pre_assemblerErrorType == 2) 
-		{
-			/* in case pre-assembler failed due to memory error */
-			printf("\nMEMORY ERROR in pre-assembler of file \"%s\". Exiting program.\n", src_filename);
-			MAIN_CLEAN_BEFORE_EXIT;
+		if (names == NULL) {
+			printf("\nMEMORY ERROR: unable to read the input files. Exiting program.\n");
+			free(jobs);
 			return 0;
 		}
+		for (i = 0; i < NUM_OF_FILES; i++) {
+			names[i] = jobs[i].name;
+		}
+		watch_ok = watchFiles(names, NUM_OF_FILES, socket_path, assembleFile);
+		free(names);
+		free(jobs);
+		freeMacroLibraries();
+		if (watch_ok == 1 && STATS_FORMAT != STATS_OFF) {
+			printStatsSummary(statsClock() - run_start);
+		}
+		return watch_ok;
+	}
 
-		/* AT THIS POINT THE .am file has been created succesfully */
-		printf("Pre-assembler of file \"%s\" is finished successfully.\n", argv[i]);
-
-		/* --(run the first stage of the assembler)-- */	
-		first_stageErrorType = first_stage(argv[i]);	
-		if (first_stageErrorType == 0) 
-		{
-			/* invalid regular error */
-			char filename[256];			
-			sprintf(filename, "%s.am", argv[i]);
-			printf("\nERROR in assembler of file \"%s\". moving to next file.\n", src_filename);
-			MAIN_CLEANUP_AND_CONTINUE;
-			continue;
-		}
-		else if (first_stageErrorType == 2) 
-		{
-			/* memory error */
-			printf("\nMEMORY ERROR in assembler of file \"%s\". Exiting program.\n", src_filename);
-			MAIN_CLEAN_BEFORE_EXIT;
+	if (num_of_workers > 1)
+	{
+		/* --(assemble the input files in parallel)-- */
+		file_error_count = runJobs(num_of_workers < NUM_OF_FILES ? num_of_workers : NUM_OF_FILES);
+		if (file_error_count == -1) {
+			freeModules();
+			freeMacroLibraries();
+			free(jobs);
+			return 0;
+		}
+	}
+	else
+	{
+		/* --(scrolling between input files)-- */
+		asm_context *ctx = newContext(1);
+		if (ctx == NULL) {
+			printf("\nMEMORY ERROR: unable to create the assembler context. Exiting program.\n");
+			free(jobs);
 			return 0;
 		}
+		Ctx = ctx;
 
-		/* --(run the second stage of the assembler)--  */ 
-		second_stageErrorType = second_stage(argv[i]);
-		if (second_stageErrorType == 0) 
+		for (i = 0; i < NUM_OF_FILES; i++)
 		{
-			/* invalid regular error */
-			char filename[256];			
-			sprintf(filename, "%s.am", argv[i]);
-			printf("\nERROR in assembler of file \"%s\". moving to next file.\n", src_filename);
-			MAIN_CLEANUP_AND_CONTINUE;
-			continue;
-		}
-		else if (second_stageErrorType == 2) 
-		{
-			/* memory error */ 
-			printf("\nMEMORY ERROR in assembler of file \"%s\". Exiting program.\n", src_filename);
-			MAIN_CLEAN_BEFORE_EXIT;
-			return 0;
-		}  
-	
-		/* AT THIS POINT THE output files have been created succesfully */
-		printf("\nAssembler of file \"%s\" is finished successfully.\n", argv[i]);
-
-		printf("\n"); /* new line before the next file*/
-		
-		/* free linked lists of the current file */
-		MAIN_CLEANUP_AND_CONTINUE;
+			int result = assembleFile(jobs[i].name, jobs[i].index);
+			flushLog(ctx); /* the diagnostics of the file, at once */
+			if (STATS_FORMAT != STATS_OFF && result != FILE_UNREADABLE && result != FILE_FATAL) {
+				printFileStats(jobs[i].name, &ctx -> stats);
+			}
+			if (result == FILE_UNREADABLE) {
+				file_error_count++;
+			}
+			else if (result == FILE_FATAL) {
+				freeContext(ctx);
+				freeModules();
+				freeMacroLibraries();
+				free(jobs);
+				return 0;
+			}
+			else if (result == FILE_CACHED) {
+				cache_hits++;
+			}
+			else {
+				cache_misses++;
+				files_done += (result == FILE_DONE);
+			}
+		}
+
+		freeContext(ctx);
+		Ctx = NULL;
+	}
+	free(jobs);
+	freeMacroLibraries(); /* all the files are done */
+
+	if (USE_CACHE == 1) {
+		printf("Build cache: %d hits, %d misses.\n", cache_hits, cache_misses);
+	}
+	if (STATS_FORMAT != STATS_OFF) {
+		printStatsSummary(statsClock() - run_start);
+	}
+
+	/* --(link the files into a single image)-- */
+	if (link_name != NULL && linkFiles(link_name) == 0) {
+		return 0;
 	}
 
 	/* in case all input files are unreadable */
-	if (file_error_count == argc-1) {
+	if (file_error_count == NUM_OF_FILES) {
 		printf("\n\nERROR: Notice! ALL of the input files are unreadable.\n");
 		printf("Unable to read files, Exiting program...\n");
 		return 0;
@@ -0,0 +1,294 @@
+/*
+ * macro_library.c - This file contains the macro libraries of the pre-assembler ('.include "<library>"').
+ * A macro library is a file of macro definitions only. It's parsed once into a macro table of its own,
+ * and that table is then shared read-only by every file (and every worker thread) that includes it, so
+ * only the macros that are local to a file are defined again for every file.
+ * The libraries are kept in a registry for the whole run of the program (the whole "--watch" session),
+ * a library is parsed again only when its file changes.
+ */
+
+#define _XOPEN_SOURCE 700 /* st_mtim */
+#include <sys/stat.h>
+#include <pthread.h>
+#include "pre_assembler.h"
+#include "macros_table.h"
+#include "../assembler/assembler.h"
+
+
+/* this struct defines a parsed macro library */
+typedef struct macro_library {
+	char *file_name;
+	long size; /* size of the file when it was parsed */
+	struct timespec mtime; /* modification time of the file when it was parsed */
+	asm_context *ctx; /* owns the macro table of the library and its diagnostics */
+	int valid; /* 1 - the library has no errors */
+	struct macro_library *next;
+} macro_library;
+
+/* the registry of the libraries, newest first (an outdated library is kept until "freeOutdatedLibraries",
+   a file being assembled may still use it) */
+static macro_library *libraries = NULL;
+static pthread_mutex_t libraries_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+/*
+ * libraryFileName - Takes the file name of a library out of the word that follows ".include".
+ * @word: The word, the name in double quotes.
+ * @name: The name to be filled, LIBRARY_NAME_SIZE + 1 characters.
+ *
+ * Return: 1 on success, 0 if the word isn't a valid library name.
+ */
+int libraryFileName(const char *word, char *name)
+{
+	int length = strlen(word);
+
+	if (length < 3 || word[0] != '"' || word[length - 1] != '"' || length - 2 > LIBRARY_NAME_SIZE) {
+		return 0;
+	}
+	memcpy(name, word + 1, length - 2);
+	name[length - 2] = '\0';
+	return strchr(name, '"') == NULL;
+}
+
+
+/*
+ * freeLibrary - Frees a library of the registry.
+ * @library: The library.
+ */
+static void freeLibrary(macro_library *library)
+{
+	asm_context *file_ctx = Ctx;
+
+	Ctx = library -> ctx;
+	freeMacro();
+	Ctx = file_ctx;
+	freeContext(library -> ctx);
+	free(library -> file_name);
+	free(library);
+}
+
+
+/*
+ * parseLibrary - Parses a library file into a new library.
+ * @file_name: Name of the library file.
+ * @st: The status of the file.
+ *
+ * The library is parsed in a context of its own, with its diagnostics buffered in the context.
+ *
+ * Return: The new library, NULL on memory error.
+ */
+static macro_library *parseLibrary(char *file_name, struct stat *st)
+{
+	macro_library *library = (macro_library *) calloc(1, sizeof(macro_library));
+	asm_context *file_ctx = Ctx;
+	source_text src;
+	FILE *fp;
+	int read_err;
+	int parse_err = 0;
+
+	if (library == NULL || (library -> file_name = (char *) malloc(strlen(file_name) + 1)) == NULL ||
+		(library -> ctx = newContext(1)) == NULL) {
+		if (library != NULL) {
+			free(library -> file_name);
+		}
+		free(library);
+		return NULL;
+	}
+	strcpy(library -> file_name, file_name);
+	library -> ctx -> file_name = library -> file_name;
+	library -> size = (long) st -> st_size;
+	library -> mtime = st -> st_mtim;
+
+	/* read the whole library file */
+	fp = fopen(file_name, "r");
+	read_err = (fp == NULL) ? 0 : readSource(fp, &src);
+	if (fp != NULL) {
+		fclose(fp);
+	}
+
+	Ctx = library -> ctx;
+	if (read_err == 0) {
+		diagPrintf(DIAG_INCLUDE, 0, "\nERROR: Unable to read macro library: \"%s\".\n", file_name);
+	}
+	else if (read_err == 2) {
+		parse_err = 2; /* memory error */
+	}
+	else {
+		parse_err = preAssembleLibrary(src.text, src.size, file_name);
+		freeSource(&src);
+	}
+	Ctx = file_ctx;
+
+	library -> valid = (parse_err == 1);
+	if (parse_err == 2) {
+		freeLibrary(library);
+		return NULL;
+	}
+	return library;
+}
+
+
+/*
+ * findLibrary - Finds the library of a given file, parsing it if it's new or if the file changed.
+ * @file_name: Name of the library file.
+ * @st: The status of the file.
+ *
+ * Return: The library, NULL on memory error.
+ */
+static macro_library *findLibrary(char *file_name, struct stat *st)
+{
+	macro_library *library;
+
+	pthread_mutex_lock(&libraries_lock);
+	for (library = libraries; library != NULL; library = library -> next) {
+		if (strcmp(library -> file_name, file_name) == 0) {
+			break; /* the newest version of the library */
+		}
+	}
+	if (library == NULL || library -> size != (long) st -> st_size ||
+		library -> mtime.tv_sec != st -> st_mtim.tv_sec || library -> mtime.tv_nsec != st -> st_mtim.tv_nsec) {
+		library = parseLibrary(file_name, st);
+		if (library != NULL) {
+			library -> next = libraries;
+			libraries = library;
+		}
+	}
+	pthread_mutex_unlock(&libraries_lock);
+	return library;
+}
+
+
+/*
+ * includeLibrary - Makes the macros of a library available to the current file.
+ * @library_name: Name of the library file.
+ * @file_name: Name of the input file, used in the diagnostics.
+ * @line_num: The line of the ".include".
+ *
+ * The diagnostics of the library are printed with every file that includes it. A library that was
+ * already included by the file is ignored, and a macro of the library can't have the name of a macro
+ * that's already defined.
+ *
+ * Return: 0 - regular error
+ *         1 - success
+ *         2 - memory error
+ */
+int includeLibrary(char *library_name, char *file_name, int line_num)
+{
+	macro_table **included;
+	macro_library *library;
+	struct stat st;
+	ptr t;
+	int i;
+
+	if (stat(library_name, &st) != 0 || !S_ISREG(st.st_mode)) {
+		diagPrintf(DIAG_INCLUDE, line_num, "\nERROR: in file \"%s\", line %d: unable to open macro library: \"%s\".\n", file_name, line_num, library_name);
+		return 0;
+	}
+
+	library = findLibrary(library_name, &st);
+	if (library == NULL) {
+		diagPrintf(DIAG_NO_MEMORY, line_num, "\nERROR: in file \"%s\", line %d: unable to allocate memory for macro library \"%s\".\n", file_name, line_num, library_name);
+		return 2;
+	}
+
+	appendLog(library -> ctx);
+	if (library -> valid == 0) {
+		diagPrintf(DIAG_INCLUDE, line_num, "\nERROR: in file \"%s\", line %d: the macro library \"%s\" has errors.\n", file_name, line_num, library_name);
+		return 0;
+	}
+
+	for (i = 0; i < Ctx -> macros.num_of_libraries; i++) {
+		if (Ctx -> macros.libraries[i] == &library -> ctx -> macros) {
+			return 1; /* already included */
+		}
+	}
+	for (t = library -> ctx -> macros.list; t != NULL; t = t -> next) {
+		if (findMacro(t -> macro_name) != NULL) {
+			diagPrintf(DIAG_MACRO_REDEFINED, line_num, "\nERROR: in file \"%s\", line %d: the macro \"%s\" of library \"%s\" is already defined.\n", file_name, line_num, t -> macro_name, library_name);
+			return 0;
+		}
+	}
+
+	included = (macro_table **) realloc(Ctx -> macros.libraries, (Ctx -> macros.num_of_libraries + 1) * sizeof(macro_table *));
+	TABLE_GROWTH();
+	if (included == NULL) {
+		diagPrintf(DIAG_NO_MEMORY, line_num, "\nERROR: in file \"%s\", line %d: unable to allocate memory for macro library \"%s\".\n", file_name, line_num, library_name);
+		return 2;
+	}
+	included[Ctx -> macros.num_of_libraries++] = &library -> ctx -> macros;
+	Ctx -> macros.libraries = included;
+	return 1;
+}
+
+
+/*
+ * nextInclude - Finds the next '.include' line of a source text.
+ * @src: The source text.
+ * @pos: The position in the text to look from, it's advanced past the line that was found.
+ * @library_name: The name of the library to be filled, LIBRARY_NAME_SIZE + 1 characters.
+ *
+ * Return: 1 if a line was found, 0 at the end of the text.
+ */
+int nextInclude(const source_text *src, int *pos, char *library_name)
+{
+	line_view view;
+	line_ir ir;
+
+	while (nextLine(src -> text, src -> size, pos, &view))
+	{
+		if (view.raw_length > LINE_SIZE || memchr(view.start, '.', view.length) == NULL) {
+			continue; /* not an ".include" line */
+		}
+		tokenizeLine(view.start, view.length, &ir);
+		if (ir.num_of_words == 2 && !ir.has_label && strcmp(ir.words[0], ".include") == 0 &&
+			libraryFileName(ir.words[1], library_name) == 1) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+
+/*
+ * freeOutdatedLibraries - Frees the libraries of the registry that were replaced by a newer version of their file.
+ * NOTICE: no file may be using an outdated library, call it between files (the files of "--watch").
+ */
+void freeOutdatedLibraries()
+{
+	macro_library **p;
+
+	pthread_mutex_lock(&libraries_lock);
+	for (p = &libraries; *p != NULL; p = &(*p) -> next) {
+		macro_library *outdated;
+		macro_library **q;
+
+		/* the versions after the newest one of the file are outdated */
+		for (q = &(*p) -> next; *q != NULL; ) {
+			if (strcmp((*q) -> file_name, (*p) -> file_name) == 0) {
+				outdated = *q;
+				*q = outdated -> next;
+				freeLibrary(outdated);
+			} else {
+				q = &(*q) -> next;
+			}
+		}
+	}
+	pthread_mutex_unlock(&libraries_lock);
+}
+
+
+/*
+ * freeMacroLibraries - Frees all the libraries of the registry.
+ * NOTICE: no file may be using a library, call it once all the files are done.
+ */
+void freeMacroLibraries()
+{
+	pthread_mutex_lock(&libraries_lock);
+	while (libraries != NULL) {
+		macro_library *next = libraries -> next;
+
+		freeLibrary(libraries);
+		libraries = next;
+	}
+	pthread_mutex_unlock(&libraries_lock);
+}
@@ -1,6 +1,10 @@
 /*
  * macro_labels.c - This file deals with the macro table using a linked list 
  * and provides various helper functions for handling macros during the pre-processing stage.
+ * The macro nodes are also kept in an open-addressing hash table, so finding a macro by its
+ * name takes a single lookup instead of a walk over the whole list.
+ * The table belongs to the assembler context of the file ("macros"), a macro that isn't defined in the file
+ * is then looked up in the tables of the macro libraries the file includes (see macro_library.c).
  */
 
 #include "macros_table.h"
@@ -8,60 +12,64 @@
 #include "../assembler/assembler.h"
 
 
+/* the macro table of the current context */
+#define macro_buckets (Ctx -> macros.buckets)
+#define macro_buckets_size (Ctx -> macros.buckets_size)
+#define macros_count (Ctx -> macros.count)
+#define Macrotail (Ctx -> macros.tail)
+
+
 /*
- * isOnlyWord - Checks whether there is only one word in the given line.
- * @line: The line to be checked.
- * 
- * This function skips leading and trailing whitespace and checks if the line contains 
- * only one word. It returns 1 if there is only one word, and 0 otherwise.
- * 
- * Return: 1 if the line contains only one word, 0 otherwise.
+ * findMacroBucket - Finds the bucket of a given macro name.
+ * @table: The macro table.
+ * @name: The macro name to be searched.
+ * @hash: The hash value of the name.
+ *
+ * This function probes the hash table linearly starting from the home bucket of the name,
+ * until it reaches the bucket holding the macro or an empty bucket.
+ *
+ * Return: The index of the bucket.
  */
-int isOnlyWord(char *line) 
+static int findMacroBucket(const macro_table *table, const char *name, unsigned int hash)
 {
-    /* Skip leading whitespace */
-    line = skipFirstWord(line);
-    
-    /* If there are more characters after the first word, it's not a single word */
-    if (*line != '\0') {
-        return 0;
-    }
-    
-    return 1;  /* If only one word is found */
+	int mask = table -> buckets_size - 1;
+	int i = hash & mask;
+
+	while (table -> buckets[i] != NULL) {
+		ptr t = table -> buckets[i];
+		if (t -> hash == hash && strcmp(t -> macro_name, name) == 0) {
+			break; /* found the macro */
+		}
+		i = (i + 1) & mask;
+	}
+	return i;
 }
- 
+
 
 /*
- * onlyTwoWords - Checks whether there are only two words in the given line.
- * @line: The line to be checked.
- * 
- * This function skips leading and trailing whitespace and checks if the line contains 
- * exactly two words. If the line contains more or less than two words, it returns 0.
- * 
- * Return: 1 if the line contains exactly two words, 0 otherwise.
+ * growMacroBuckets - Doubles the num of buckets and rehashes all the macros.
+ *
+ * Return: 1 on success, 0 on memory error.
  */
-int onlyTwoWords(char *line)
+static int growMacroBuckets()
 {
-	/* skip leading spaces */
-	line = skipFirstWord(line);
-	
-	/* If there is no macro definition */
-    if (*line == '\0') {
-		printf("\nERROR: Notice! there's no defined name following the macro (\"macr\") definition. \n");
-        return 0;
-    }
-
-	/* find the end of the second word */
-	while (*line && !isspace(*line)) {line++; }
-	
-	/* skip trailing whitespace after the second word */
-	while (*line && isspace(*line)) {line++; }
+	int new_size = (macro_buckets_size == 0) ? MACRO_TABLE_INIT_SIZE : macro_buckets_size * 2;
+	ptr *new_buckets = (ptr *) calloc(new_size, sizeof(ptr));
+	ptr t;
+	TABLE_GROWTH();
+
+	if (new_buckets == NULL) {
+		return 0;
+	}
 
-	/* If there is a third word */
-    if (*line != '\0') {
-        return 0;
-    }
+	free(macro_buckets);
+	macro_buckets = new_buckets;
+	macro_buckets_size = new_size;
 
+	/* re-insert every macro */
+	for (t = Ctx -> macros.list; t != NULL; t = t -> next) {
+		macro_buckets[findMacroBucket(&Ctx -> macros, t -> macro_name, t -> hash)] = t;
+	}
 	return 1;
 }
 
@@ -91,124 +99,70 @@ int validMacroName(char* name)
 
 
 /*
- * isMacro - Checks if the given word matches a defined macro name.
- * @word: The word to be checked.
+ * findMacro - Finds the macro defined with the given name.
+ * @macro_name: The name of the macro.
  * 
- * This function traverses the macro linked list to check if the given word matches 
- * any macro name. It returns 1 if the word is a defined macro, and 0 otherwise.
+ * The macros of the file come first, and then the macros of the included libraries, in the order
+ * they were included.
  * 
- * Return: 1 if the word is a macro, 0 otherwise.
+ * Return: The macro node, or NULL if no such macro is defined.
  */
-int isMacro(char *word) 
+ptr findMacro(char *macro_name)
 {
-	ptr t = hptr;	
-	while (t) {
-		if (strcmp(t -> macro_name, word) == 0) {
-			return 1;
-		}
-		t = t -> next;
-	}	
-	return 0;
-}
+	unsigned int hash;
+	ptr t = NULL;
+	int i;
 
+	STAT_COUNT(macro_lookups);
+	if (macros_count == 0 && Ctx -> macros.num_of_libraries == 0) {
+		return NULL; /* the table is empty */
+	}
 
-/*
- * getMacro - Retrieves the content of the given macro name.
- * @macro_name: The name of the macro.
- * 
- * This function traverses the macro linked list to find the node with the given 
- * macro name and returns the macro content. If the macro name is not found, 
- * it returns NULL.
- * 
- * Return: The content of the macro, or NULL if not found.
- */
-char *getMacro(char *macro_name) 
-{
-	ptr t = hptr;	
-	while (t) 
-	{
-		if (strcmp(t -> macro_name, macro_name) == 0) {
-			return (t -> macro_content);
+	hash = hashName(macro_name);
+	if (macros_count > 0) {
+		t = macro_buckets[findMacroBucket(&Ctx -> macros, macro_name, hash)];
+	}
+	for (i = 0; t == NULL && i < Ctx -> macros.num_of_libraries; i++) {
+		macro_table *library = Ctx -> macros.libraries[i];
+		if (library -> count > 0) {
+			t = library -> buckets[findMacroBucket(library, macro_name, hash)];
 		}
-		t = t-> next;	
-	}		
+	}
+	return t;
 }
 
 
 /*
- * get_first_word - Retrieves the first word from the given line.
- * @line: The line to be processed.
+ * isMacro - Checks if the given word matches a defined macro name.
+ * @word: The word to be checked.
  * 
- * This function skips leading whitespace and finds the first word in the line.
- * It copies the first word into a static buffer and returns a pointer to it.
+ * This function looks the given word up in the macro hash table. It returns 1 if
+ * the word is a defined macro, and 0 otherwise.
  * 
- * Return: The first word in the line.
+ * Return: 1 if the word is a macro, 0 otherwise.
  */
-char* get_first_word(const char* line) 
+int isMacro(char *word) 
 {
-    /* Skip leading whitespace */
-    while (*line && isspace(*line)) {line++; }
-
-    /* Find the end of the first word */
-    const char* end = line;
-    while (*end && !isspace(*end)) {end++; }
-    
-    /* Calculate length of the first word */
-    size_t length = end - line;
-    
-	/* Create a static buffer to hold the first word */
-    static char first_word[81];  
-	if (length >= sizeof(first_word)) {
-        printf("Word is too long to fit in the buffer\n");
-        return NULL;
-    }
-    
-    /* Copy the first word */
-    strncpy(first_word, line, length);
-    first_word[length] = '\0';  /* Null-terminate the string */
-
-    return first_word;
+	return findMacro(word) != NULL;
 }
 
 
 /*
- * get_second_word - Retrieves the second word from the given line.
- * @line: The line to be processed.
+ * getMacro - Retrieves the content of the given macro name.
+ * @macro_name: The name of the macro.
  * 
- * This function skips the first word and leading whitespace, then finds the second 
- * word in the line. It copies the second word into a static buffer and returns a 
- * pointer to it. If there is no second word, it returns an empty string.
+ * This function looks the given macro name up in the macro hash table and returns
+ * the macro content. If the macro name is not found, it returns NULL.
  * 
- * Return: The second word in the line, or an empty string if not found.
+ * Return: The content of the macro, or NULL if not found.
  */
-char* get_second_word(char* line) {
-    
-	if (findNumOfWords(line) < 2) {
-        return ""; /* no second word */
-    }
-
-	/* Skip leading whitespace */
-    line = skipFirstWord(line);
-    
-    /* Find the end of the second word */
-    const char* end = line;
-    while (*end && !isspace(*end)) {end++; }
-
-    /* Calculate length of the second word */
-    size_t length = end - line;
-    
-    /* Create a static buffer to hold the second word */
-    static char second_word[80];  
-	if (length >= sizeof(second_word)) {
-        printf("Word is too long to fit in the buffer\n");
-        return NULL;
-    }
-    
-    /* Copy the second word */
-    strncpy(second_word, line, length);
-    second_word[length] = '\0';  /* Null-terminate the string */
-    
-    return second_word;
+char *getMacro(char *macro_name) 
+{
+	ptr t = findMacro(macro_name);
+	if (t == NULL) {
+		return NULL;
+	}
+	return t -> macro_content;
 }
 
 
@@ -218,116 +172,104 @@ char* get_second_word(char* line) {
  * 
  * This function creates a new node for the macro linked list with the given 
  * macro name and initializes its content to an empty string. It inserts the 
- * new node at the end of the list.
+ * new node at the end of the list and into the hash table.
  * 
  * Return: 1 on success, 0 on failure.
  */
 int addMacro(char *macro_name)
 {	
-	ptr t = (ptr) malloc(sizeof(m_item));
-	if (!t) {
-		printf("\nERROR: unable to allocate memory for macro \"%s\".\n", macro_name);
+	ptr t;
+
+	/* keep the load factor under 3/4 */
+	if ((macros_count + 1) * 4 > macro_buckets_size * 3) {
+		if (growMacroBuckets() == 0) {
+			diagPrintf(DIAG_NO_MEMORY, 0, "\nERROR: unable to allocate memory for macro \"%s\".\n", macro_name);
+			return 0;
+		}
+	}
+
+	/* the node, its name and its content all belong to the arena, a partly built node is never freed */
+	t = (ptr) arenaAlloc(&Ctx -> arena, sizeof(m_item));
+	if (t == NULL || (t -> macro_name = arenaCopy(&Ctx -> arena, macro_name)) == NULL ||
+		(t -> macro_content = (char *) arenaAlloc(&Ctx -> arena, MACRO_CONTENT_INIT_SIZE)) == NULL) {
+		diagPrintf(DIAG_NO_MEMORY, 0, "\nERROR: unable to allocate memory for macro \"%s\".\n", macro_name);
 		return 0;
 	}
-	
-	/* inserting the data to each node */
-    t -> macro_name = (char *) malloc(strlen(macro_name) + 1);
-    if ((t -> macro_name) == NULL) {
-        printf("\nERROR: unable to allocate memory for macro name \"%s\".\n", macro_name);
-        free(t); /* Clean up allocated memory */
-        return 0;
-    }
-    strcpy(t -> macro_name, macro_name);
-
-	t -> macro_content = (char *) malloc(1); /* Allocate for an empty string */
-    if ((t -> macro_content) == NULL) {
-        printf("\nERROR: unable to allocate memory for macro content \"%s\".\n", macro_name);
-        free(t -> macro_name); /* Clean up allocated memory */
-        free(t);
-        return 0;
-    }
-	t -> macro_content[0] = '\0';
+	t -> hash = hashName(macro_name);
+	t -> macro_content[0] = '\0'; /* an empty string */
+	t -> content_size = 0;
+	t -> content_capacity = MACRO_CONTENT_INIT_SIZE;
 
 	t -> next = NULL;
 	
-	/* assign the node to the list. */
-	if (hptr == NULL) {
-		hptr = t; /* if the list is empty, make this the first node */
+	/* assign the node to the end of the list. */
+	if (Ctx -> macros.list == NULL) {
+		Ctx -> macros.list = t; /* if the list is empty, make this the first node */
 	} else {
-		ptr last = hptr;
-		while (last -> next != NULL) {
-            last = last -> next;
-        }
-		last -> next = t;
+		Macrotail -> next = t;
 	}
+	Macrotail = t;
+
+	/* and to the hash table */
+	macro_buckets[findMacroBucket(&Ctx -> macros, t -> macro_name, t -> hash)] = t;
+	macros_count++;
 	return 1;
 }
 
 
 /*
- * addMacroContent - Adds content to the macro with the given name.
- * @line: The content to be added.
- * @macro_name: The name of the macro.
+ * addMacroContent - Adds content to the given macro.
+ * @line: The content to be added, it doesn't have to be null-terminated.
+ * @length: The num of characters in the content.
+ * @t: The macro node.
  * 
- * This function finds the node with the given macro name in the macro linked list 
- * and appends the provided content to the macro's existing content. If the macro 
- * content is initially empty, it allocates memory for the new content.
+ * This function appends the provided content to the end of the macro's existing content.
+ * The content buffer is doubled whenever it's full (a new buffer in the arena), so a macro of
+ * n lines is stored in linear time and space.
  * 
  * Return: 1 on success, 0 on failure.
  */
-int addMacroContent(char *line, char *macro_name) {	
-	ptr t = hptr;	
-	while (t) 
-	{
-		if (strcmp(t -> macro_name, macro_name) == 0) 
-		{
-			/* found the node. */
-			size_t new_size = strlen(line) + 1;
-			if (t -> macro_content == NULL) 
-			{
-				t -> macro_content = (char *)malloc(new_size); /* resize the buffer */
-				if (t -> macro_content == NULL) {
-					printf("\nUnable to allocate memory for macro content.\n");
-					return 0;
-				}
-				strcpy(t->macro_content, line);
-
-			} else {
-				new_size += strlen(t -> macro_content); /* resize the buffer, adding the new content*/
-				char *new_content = (char *)realloc(t -> macro_content, new_size);
-				if (new_content == NULL) {
-					printf("\nUnable to reallocate memory for macro content.\n");
-					return 0;
-				}
-				t -> macro_content = new_content;
-				strcat(t -> macro_content, line);
-			}
-			return 1;
+int addMacroContent(const char *line, int length, ptr t) 
+{	
+	/* make room for the line and the null-terminator */
+	if (t -> content_size + length + 1 > t -> content_capacity) {
+		int new_capacity = t -> content_capacity * 2;
+		char *new_content;
+		while (t -> content_size + length + 1 > new_capacity) {
+			new_capacity *= 2;
+		}
+		new_content = (char *) arenaAlloc(&Ctx -> arena, new_capacity);
+		if (new_content == NULL) {
+			diagPrintf(DIAG_NO_MEMORY, 0, "\nUnable to reallocate memory for macro content.\n");
+			return 0;
 		}
-		t = t->next;
+		memcpy(new_content, t -> macro_content, t -> content_size); /* the old content stays in the arena */
+		t -> macro_content = new_content;
+		t -> content_capacity = new_capacity;
 	}
-	return 0;
+
+	memcpy(t -> macro_content + t -> content_size, line, length);
+	t -> content_size += length;
+	t -> macro_content[t -> content_size] = '\0';
+	return 1;
 }
 
 
 /*
  * freeMacro - Frees all the macros in the macros table.
  * 
- * This function traverses the macro linked list and frees the memory allocated 
- * for each node, including the macro name and content.
+ * The macro nodes, names and contents belong to the arena of the context (freed when it's reset),
+ * so only the list is emptied, and then the hash table is freed.
+ * The included libraries are only forgotten, they belong to the library registry.
  */
 void freeMacro() 
 {
-	ptr p;
-	while (hptr) 
-	{
-		p = hptr;
-		hptr = hptr -> next;
-		/* free node */
-		free(p -> macro_content);
-		free(p -> macro_name);	
-		free(p);
-	}	
-
-	free(hptr);
-}
\ No newline at end of file
+	Ctx -> macros.list = NULL;
+	free(macro_buckets);
+	macro_buckets = NULL;
+	macro_buckets_size = macros_count = 0;
+	Macrotail = NULL;
+	free(Ctx -> macros.libraries);
+	Ctx -> macros.libraries = NULL;
+	Ctx -> macros.num_of_libraries = 0;
+}
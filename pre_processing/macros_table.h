@@ -10,27 +10,29 @@
 #include <ctype.h>
 
 
+#define MACRO_TABLE_INIT_SIZE 64 /* initial num of hash buckets, must be a power of 2 */
+#define MACRO_CONTENT_INIT_SIZE 128 /* initial num of characters in a macro content */
+
 /* pointer node */
 typedef struct node *ptr;
 
 /* struct of a macro node */
 typedef struct node {
 	char *macro_name;
-	char *macro_content;
+	unsigned int hash; /* hash value of the macro name */
+	char *macro_content; /* the lines of the macro, one after the other */
+	int content_size; /* num of characters in the content */
+	int content_capacity; /* num of characters allocated for the content */
 	struct node *next;
 } m_item;
 
-/* Global head pointer for the linked list */
-struct node *hptr;
+/* NOTICE: the macro list itself is kept in the assembler context ("macros" in assembler.h) */
 
 /* Declerations: */
-int isOnlyWord(char*);
-int onlyTwoWords(char*);
 int validMacroName(char*);
 int isMacro(char*);
+ptr findMacro(char*);
 char *getMacro(char*);
-char* get_first_word(const char*);
-char* get_second_word(char*);
 int addMacro(char*);
-int addMacroContent(char*, char*);
+int addMacroContent(const char*, int, ptr);
 void freeMacro();
\ No newline at end of file
@@ -1,121 +1,163 @@
 /*
  * pre_assembler.c - Pre-assembler function for the assembler project
  * This file contains the pre-assembler function which processes a given input file,
- * handling macro definitions and generating an intermediate file (.am) for further assembly stages.
+ * handling macro definitions and generating the expanded source (.am) for further assembly stages.
+ * The expanded source is kept in memory (the "am_buffer" of the context), the first stage reads its lines from there.
+ * A line '.include "<library>"' makes the macros of a macro library (a file of macro definitions only) available to the file.
  */
 
 #include "pre_assembler.h"
 #include "macros_table.h"
-#define LINE_SIZE 81
+#include "../assembler/assembler.h"
+
+
+int EMIT_AM = 0;
 
 
 /*
- * pre_assembler - Handles the pre-assembling of a given file.
- * @fp: File pointer to the input file to be pre-assembled.
- * @num_of_file: Index of the current file being processed.
+ * writeAmFile - Writes the expanded source to "pre_processing/<name>.am".
+ * @name_of_file: Name of the input file being processed.
+ *
+ * Return: 1 on success, 0 if the file couldn't be created.
+ */
+int writeAmFile(char *name_of_file)
+{
+	char am_filename[256 + 19];
+	FILE *fd;
+
+	sprintf(am_filename, "pre_processing/%s.am", name_of_file);
+	fd = fopen(am_filename, "w");
+	if (fd == NULL) {
+		diagPrintf(DIAG_OUTPUT_FILE, 0, "ERROR: Unable to create file: \"%s\".\n", am_filename);
+		return 0;
+	}
+
+	fwrite(Ctx -> am_buffer.text, 1, Ctx -> am_buffer.size, fd);
+	fclose(fd);
+	return 1;
+}
+
+
+/*
+ * freeAmBuffer - Frees the expanded source of the current file.
+ */
+void freeAmBuffer()
+{
+	free(Ctx -> am_buffer.text);
+	Ctx -> am_buffer.text = NULL;
+	Ctx -> am_buffer.size = Ctx -> am_buffer.capacity = 0;
+}
+
+
+/*
+ * expandSource - Expands the macros of a source text into the expanded source.
+ * @text: The source text, it doesn't have to be null-terminated.
+ * @size: The num of characters in the source text.
  * @name_of_file: Name of the input file being processed.
+ * @library: 1 - the text is a macro library, it may only define macros (nothing is expanded).
+ * @line_num: The num of lines before the text (the line numbers of the messages).
  * 
- * This function processes the input file line by line, handling macro definitions and 
- * replacing macro calls with their corresponding content. It creates an intermediate 
- * file (.am) that is used in subsequent stages of the assembler. The function returns 
- * different values based on the type of error encountered or success.
+ * Every line is a view into the source text, its length is checked once and then it's
+ * tokenized once. Lines are appended to the expanded source (or to the macro being defined)
+ * straight from the source text.
  * 
- * Return: 0 - regular error (skip to next file)
- *         1 - success (move to next file)
- *         2 - memory allocation error (shutdown program)
+ * Return: 0 - regular error
+ *         1 - success
+ *         2 - memory allocation error
  */
-int pre_assembler(FILE *fp, int num_of_file, char *name_of_file)
-{	
-	#define EXTRA_NAME_SPACE 19
+static int expandSource(const char *text, int size, char *name_of_file, int library, int line_num)
+{
 	int MACRO_FLAG = 0;
-	char *MACRO_NAME;
-	int line_num = 0;
+	ptr MACRO = NULL; /* the macro being defined */
 	int error0Count = 0;
-
-	/* creating the .am file for the pre-assembler */
-    size_t newNameLen = strlen(name_of_file) + EXTRA_NAME_SPACE; 
-    char *newName = malloc(newNameLen);
-    if (newName == NULL) {
-        printf("ERROR: Memory allocation for file \"%s\" name failed.\n", name_of_file);
-        return 2;
-    }
-    snprintf(newName, newNameLen, "pre_processing/%s.am", name_of_file);
-	
-	FILE *fd = fopen(newName, "w");
-	if (fd == NULL) {
-		printf("ERROR: Unable to create file: \"%s\".\n", newName);
-		return 0; /* moving to the next file */
-	}	
-
-	free(newName);
+	int pos = 0; /* reading position in the source text */
+	line_view view;
+	line_ir ir;
 
 	/* read line by line */
-	char line[LINE_SIZE + 2] = "";
-	line[81] = '\0';
-	while (fgets(line, (LINE_SIZE + 2), fp)) 
+	while (nextLine(text, size, &pos, &view)) 
 	{
+		char *word;
+		ptr macro;
+
+		/* check if the file already has too many errors ("--max-errors") */
+		if (tooManyErrors(name_of_file)) {
+			error0Count++;
+			break;
+		}
+
 		line_num++; /* first line is 1 */
+		STAT_COUNT(lines);
 		/* make sure the line size is valid */
-		if (line[81] != '\0') {
-			printf("\nERROR: in file \"%s\": line %d exceeds the limit.\n", name_of_file, line_num);
+		if (view.raw_length > LINE_SIZE) {
+			diagPrintf(DIAG_LINE_TOO_LONG, line_num, "\nERROR: in file \"%s\": line %d exceeds the limit.\n", name_of_file, line_num);
 			error0Count++;
-			char c;
-			while ((c = fgetc(fp)) != '\n' && (c != EOF));
-			line[81] = '\0';
 			continue; /* pick the error and move to next line */
 		}
 	
 		/* ignore comments*/
-		if (line[0] == ';') {
+		if (view.length > 0 && view.start[0] == ';') {
 			continue;
 		}
 
-		/* Reading the first word in a line. */
-		char *word = get_first_word(line); 
-		if (word == NULL) {
-            continue; /* Skip blank lines */
-        }
+		/* Reading the first word in a line, a label definition is never a macro word. */
+		tokenizeLine(view.start, view.length, &ir);
+		word = (ir.num_of_words == 0 || ir.has_label) ? "" : ir.words[0];
 
 		/* check if we found an existing macro. */
-		if (isMacro(word) == 1) 
+		macro = (*word != '\0') ? findMacro(word) : NULL;
+		if (macro != NULL) 
 		{ 
 			/* check that there are no excess words/letters */
-			if (isOnlyWord(line) == 0) {
-				printf("\nERROR: in file \"%s\": line %d there are excess letters after calling a macro.\n", name_of_file, line_num);
+			if (ir.num_of_words != 1) {
+				diagPrintf(DIAG_MACRO_CALL, line_num, "\nERROR: in file \"%s\": line %d there are excess letters after calling a macro.\n", name_of_file, line_num);
+				error0Count++;
+				continue; /* pick the error and move to next line */
+			}
+			if (library == 1) {
+				diagPrintf(DIAG_LIBRARY_CONTENT, line_num, "\nERROR: in macro library \"%s\", line %d: a macro library can't call a macro.\n", name_of_file, line_num);
 				error0Count++;
 				continue; /* pick the error and move to next line */
 			}
 
-			char *content = getMacro(word);
-			fputs(content, fd);	
+			/* expand the whole macro at once */
+			if (appendText(&Ctx -> am_buffer, macro -> macro_content, macro -> content_size) == 0) {
+				diagPrintf(DIAG_NO_MEMORY, line_num, "\nERROR: in file \"%s\", line %d: Unable to expand macro: \"%s\".\n", name_of_file, line_num, word);
+				return 2;
+			}
 			continue;
 		} 
 		
 		/* finding a definition of a macro */
 		else if (strcmp(word, "macr") == 0) 
 		{
+			char *MACRO_NAME;
+
 			/* check that there are no excess words/letters */
-			if (onlyTwoWords(line) == 0) {
-				printf("\nERROR: in file \"%s\": line %d there are excess letters after a macro definition.\n", name_of_file, line_num);
+			if (ir.num_of_words == 1) {
+				diagPrintf(DIAG_MACRO_DEFINITION, line_num, "\nERROR: Notice! there's no defined name following the macro (\"macr\") definition. \n");
+			}
+			if (ir.num_of_words != 2) {
+				diagPrintf(DIAG_MACRO_DEFINITION, line_num, "\nERROR: in file \"%s\": line %d there are excess letters after a macro definition.\n", name_of_file, line_num);
 				error0Count++;
 				continue; /* pick the error and move to next line */
 			}
 							
-			MACRO_NAME = get_second_word(line);
+			MACRO_NAME = ir.words[1];
 			/* check that the macro name is valid. */
 			if (strlen(MACRO_NAME) > 31) {
-				printf("\nERROR: in file \"%s\", line %d: the macro length exceeds the limit.\n", name_of_file, line_num);
+				diagPrintf(DIAG_MACRO_NAME, line_num, "\nERROR: in file \"%s\", line %d: the macro length exceeds the limit.\n", name_of_file, line_num);
 				error0Count++;
 				continue; /* pick the error and move to next line */
 			}
 			if (validMacroName(MACRO_NAME) == 0) {
-				printf("\nERROR: in file \"%s\", line %d: there's an invalid macro name called \"%s\".\n", name_of_file, line_num, MACRO_NAME);
+				diagPrintf(DIAG_MACRO_NAME, line_num, "\nERROR: in file \"%s\", line %d: there's an invalid macro name called \"%s\".\n", name_of_file, line_num, MACRO_NAME);
 				error0Count++;
 				continue; /* pick the error and move to next line */
 			}
 			/* check that the name isn't already an existing macro name */
 			else if (isMacro(MACRO_NAME)) {
-				printf("\nERROR: in file \"%s\", line %d: there is another macro definition with the same name of \"%s\".\n", name_of_file, line_num, MACRO_NAME);
+				diagPrintf(DIAG_MACRO_REDEFINED, line_num, "\nERROR: in file \"%s\", line %d: there is another macro definition with the same name of \"%s\".\n", name_of_file, line_num, MACRO_NAME);
 				error0Count++;
 				continue; /* pick the error and move to next line */
 			}
@@ -123,10 +165,10 @@ int pre_assembler(FILE *fp, int num_of_file, char *name_of_file)
 			MACRO_FLAG = 1;
 			/* put macro name in the macro table */
 			if (addMacro(MACRO_NAME) == 0) {
-				printf("\nERROR: in file \"%s\", line %d: Unable to create a macro node for macro: \"%s\".", name_of_file, line_num, MACRO_NAME);
-				fclose(fd);
+				diagPrintf(DIAG_NO_MEMORY, line_num, "\nERROR: in file \"%s\", line %d: Unable to create a macro node for macro: \"%s\".", name_of_file, line_num, MACRO_NAME);
 				return 2;
 			}
+			MACRO = findMacro(MACRO_NAME);
 
 			continue;
 		} 
@@ -135,36 +177,181 @@ int pre_assembler(FILE *fp, int num_of_file, char *name_of_file)
 		else if ((MACRO_FLAG == 1) && (strcmp(word, "endmacr") != 0))
 		{
 			/* put this line in the macro table */
-			if (addMacroContent(line, MACRO_NAME) == 0) {
-				printf("\nERROR: ERROR: in file \"%s\": Unable to store macro: \"%s\".\n", name_of_file, MACRO_NAME);
-				fclose(fd);
+			if (addMacroContent(view.start, view.raw_length, MACRO) == 0) {
+				diagPrintf(DIAG_NO_MEMORY, 0, "\nERROR: ERROR: in file \"%s\": Unable to store macro: \"%s\".\n", name_of_file, MACRO -> macro_name);
 				return 2;
 			}
 			continue;
 		} 
 		
+		/* including a macro library */
+		else if (strcmp(word, ".include") == 0)
+		{
+			char library_name[LIBRARY_NAME_SIZE + 1];
+			int include_err;
+
+			if (library == 1) {
+				diagPrintf(DIAG_LIBRARY_CONTENT, line_num, "\nERROR: in macro library \"%s\", line %d: a macro library can't include another library.\n", name_of_file, line_num);
+				error0Count++;
+				continue; /* pick the error and move to next line */
+			}
+			if (ir.num_of_words != 2 || libraryFileName(ir.words[1], library_name) == 0) {
+				diagPrintf(DIAG_INCLUDE, line_num, "\nERROR: in file \"%s\", line %d: \".include\" must be followed by the name of a macro library in double quotes.\n", name_of_file, line_num);
+				error0Count++;
+				continue; /* pick the error and move to next line */
+			}
+
+			include_err = includeLibrary(library_name, name_of_file, line_num);
+			if (include_err == 2) {
+				return 2; /* memory error */
+			}
+			else if (include_err == 0) {
+				error0Count++;
+			}
+			continue;
+		}
+
 		/* reached the end of a macro definition */
-		else if ((strcmp(word, "endmacr") == 0) && (isOnlyWord(line) == 1)) 
+		else if ((strcmp(word, "endmacr") == 0) && (ir.num_of_words == 1)) 
 		{
 			MACRO_FLAG = 0;
-			*MACRO_NAME = '\0'; 
+			MACRO = NULL;
 			continue;
 		}
 		else
 		{
+			/* a macro library holds nothing but its macro definitions */
+			if (library == 1) {
+				if (ir.num_of_words > 0) {
+					diagPrintf(DIAG_LIBRARY_CONTENT, line_num, "\nERROR: in macro library \"%s\", line %d: a macro library may only contain macro definitions.\n", name_of_file, line_num);
+					error0Count++;
+				}
+				continue;
+			}
+
 			/* if reached here -- It's just a random text unrelated to a macro stuff */
-			fputs(line, fd);
+			if (appendText(&Ctx -> am_buffer, view.start, view.raw_length) == 0) {
+				diagPrintf(DIAG_NO_MEMORY, line_num, "\nERROR: in file \"%s\", line %d: Unable to store the line.\n", name_of_file, line_num);
+				return 2;
+			}
 		}
-	
-		*line = '\0';		
 	}	
 
 	if (error0Count > 0) {
-		fclose(fd);
 		return 0;
 	}
-	/* save .am file */
-	fclose(fd);
 
 	return 1;
 }
+
+
+/*
+ * preAssembleText - Handles the pre-assembling of a source text that's already in memory.
+ * @text: The source text, it doesn't have to be null-terminated.
+ * @size: The num of characters in the source text.
+ * @name_of_file: Name of the input file, used in the diagnostics.
+ * 
+ * The expanded source of the current context is restarted, and the source text is expanded
+ * into it. It's written to a .am file only when EMIT_AM is on.
+ * 
+ * Return: 0 - regular error (skip to next file)
+ *         1 - success (move to next file)
+ *         2 - memory allocation error (shutdown program)
+ */
+int preAssembleText(const char *text, int size, char *name_of_file)
+{
+	int expand_err = preAssembleLines(text, size, name_of_file, 0);
+
+	if (expand_err == 2) {
+		return 2; /* memory error */
+	}
+
+	/* save .am file (debug only) */
+	if (EMIT_AM == 1) {
+		writeAmFile(name_of_file);
+	}
+
+	return expand_err;
+}
+
+
+/*
+ * preAssembleLines - Handles the pre-assembling of some lines of a source text, without writing a .am file.
+ * @text: The lines, they don't have to be null-terminated.
+ * @size: The num of characters in the lines.
+ * @name_of_file: Name of the input file, used in the diagnostics.
+ * @line_num: The num of lines of the source before the given lines.
+ * 
+ * The expanded source of the current context is restarted, and the lines are expanded into it
+ * (a segment of an incremental session is expanded on its own, see assembler/assemble.c).
+ * 
+ * Return: 0 - regular error
+ *         1 - success
+ *         2 - memory allocation error
+ */
+int preAssembleLines(const char *text, int size, char *name_of_file, int line_num)
+{
+	/* start an empty expanded source */
+	Ctx -> am_buffer.size = 0;
+	if (appendText(&Ctx -> am_buffer, "", 0) == 0) {
+		diagPrintf(DIAG_NO_MEMORY, 0, "ERROR: Memory allocation for file \"%s\" failed.\n", name_of_file);
+		return 2;
+	}
+
+	return expandSource(text, size, name_of_file, 0, line_num);
+}
+
+
+/*
+ * preAssembleLibrary - Defines the macros of a macro library in the macro table of the current context.
+ * @text: The text of the library, it doesn't have to be null-terminated.
+ * @size: The num of characters in the text.
+ * @library_name: Name of the library file, used in the diagnostics.
+ * 
+ * Return: 0 - regular error
+ *         1 - success
+ *         2 - memory allocation error
+ */
+int preAssembleLibrary(const char *text, int size, char *library_name)
+{
+	return expandSource(text, size, library_name, 1, 0);
+}
+
+
+/*
+ * pre_assembler - Handles the pre-assembling of a given file.
+ * @fp: File pointer to the input file to be pre-assembled.
+ * @num_of_file: Index of the current file being processed.
+ * @name_of_file: Name of the input file being processed.
+ * 
+ * This function reads the whole input file at once, and then expands it line by line,
+ * handling macro definitions and replacing macro calls with their corresponding content.
+ * The expanded source is kept in memory (the "am_buffer" of the context) for the subsequent stages of the
+ * assembler, and written to a .am file only when EMIT_AM is on. The function returns
+ * different values based on the type of error encountered or success.
+ * 
+ * Return: 0 - regular error (skip to next file)
+ *         1 - success (move to next file)
+ *         2 - memory allocation error (shutdown program)
+ */
+int pre_assembler(FILE *fp, int num_of_file, char *name_of_file)
+{	
+	source_text src;
+	int read_err;
+	int pre_assembler_err;
+
+	/* read the whole input file */
+	read_err = readSource(fp, &src);
+	if (read_err == 0) {
+		diagPrintf(DIAG_FILE_UNREADABLE, 0, "ERROR: Unable to read file: \"%s\".\n", name_of_file);
+		return 0; /* moving to the next file */
+	}
+	else if (read_err == 2) {
+		diagPrintf(DIAG_NO_MEMORY, 0, "ERROR: Memory allocation for file \"%s\" failed.\n", name_of_file);
+		return 2;
+	}
+
+	pre_assembler_err = preAssembleText(src.text, src.size, name_of_file);
+	freeSource(&src);
+	return pre_assembler_err;
+}
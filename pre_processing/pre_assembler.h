@@ -1,7 +1,8 @@
 /*
  * pre_processing.h - Header file for pre-processing functions in the assembler project
  * This file contains the declarations of functions used in the pre-processing stage of the assembler.
- * The pre-processing stage involves handling macros and creating intermediate files for further assembly stages.
+ * The pre-processing stage involves handling macros and creating the expanded source (.am) for further assembly stages.
+ * The expanded source is kept in memory, it's written to a .am file only when asked for ("--emit-am").
  */
 
 #include <stdio.h>
@@ -9,5 +10,63 @@
 #include <string.h>
 #include <ctype.h>
 
+
+/*  ---------------------
+   | (EXPANDED SOURCE) |
+   ---------------------  
+ ~(The macro-expanded source of the current file, shared by the pre-assembler and the first stage)~ */
+
+/* NOTICE: the expanded source itself is kept in the assembler context ("am_buffer" in assembler.h) */
+
+/* when turned on ("--emit-am"), the expanded source is also written to "pre_processing/<name>.am" */
+extern int EMIT_AM;
+
+
+
+/*  ------------------
+   | (SOURCE INPUT) |
+   ------------------  
+ ~(A source file is read into memory at once, its lines are handed out as views into the text)~ */
+
+#define SOURCE_STREAM_INIT_SIZE 4096 /* initial num of characters read from a pipe (a source of unknown size) */
+
+typedef struct {
+	char *text; /* the whole file, null-terminated */
+	int size; /* num of characters in the file */
+} source_text;
+
+/* a line inside a text, not null-terminated */
+typedef struct {
+	const char *start;
+	int length; /* num of characters, without the '\n' */
+	int raw_length; /* num of characters, with the '\n' (if there is one) */
+} line_view;
+
+
+/*  ---------------------
+   | (MACRO LIBRARIES) |
+   ---------------------  
+ ~(Files of macro definitions, included by '.include "<library>"', see macro_library.c)~ */
+
+/* a library is parsed once per run of the program (parsed again only when its file changes), and its macros
+   are shared read-only by every file and every worker thread that includes it */
+
+#define LIBRARY_NAME_SIZE 255 /* max num of characters in the file name of a library */
+
+int libraryFileName(const char*, char*);
+int includeLibrary(char*, char*, int);
+int nextInclude(const source_text*, int*, char*);
+void freeOutdatedLibraries();
+void freeMacroLibraries();
+
+
 /* declerations: */
-int pre_assembler(FILE*, int, char*);
\ No newline at end of file
+int pre_assembler(FILE*, int, char*);
+int preAssembleText(const char*, int, char*);
+int preAssembleLines(const char*, int, char*, int);
+int preAssembleLibrary(const char*, int, char*);
+int readSource(FILE*, source_text*);
+int nextLine(const char*, int, int*, line_view*);
+void freeSource(source_text*);
+int writeAmFile(char*);
+void freeAmBuffer();
\ No newline at end of file
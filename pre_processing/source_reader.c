@@ -0,0 +1,127 @@
+/*
+ * source_reader.c - This file contains the input layer of the assembler.
+ * A source file is read into memory with a single read, and then handed out as line views:
+ * every view points straight into the text, so the lines are never copied.
+ * The same line views are used over the expanded source by the first stage.
+ */
+
+#include <limits.h>
+#include "pre_assembler.h"
+
+
+/*
+ * readStream - Reads a whole source of unknown size (a pipe, such as stdin) into memory.
+ * @fp: File pointer to the source.
+ * @src: The source text to be filled.
+ *
+ * Return: 1 on success, 0 on read error, 2 on memory error.
+ */
+static int readStream(FILE *fp, source_text *src)
+{
+	int capacity = SOURCE_STREAM_INIT_SIZE;
+	size_t length;
+
+	src -> text = (char *) malloc(capacity + 1);
+	if (src -> text == NULL) {
+		return 2; /* memory error */
+	}
+
+	while ((length = fread(src -> text + src -> size, 1, capacity - src -> size, fp)) > 0) {
+		src -> size += (int) length;
+		if (src -> size == capacity) {
+			char *text = (capacity <= INT_MAX / 2 - 1) ? (char *) realloc(src -> text, 2 * capacity + 1) : NULL;
+			if (text == NULL) {
+				freeSource(src);
+				return 2; /* memory error, or the source is too big */
+			}
+			src -> text = text;
+			capacity *= 2;
+		}
+	}
+
+	if (ferror(fp)) {
+		freeSource(src);
+		return 0;
+	}
+	src -> text[src -> size] = '\0';
+	return 1;
+}
+
+
+/*
+ * readSource - Reads a whole source file into memory.
+ * @fp: File pointer to the source file.
+ * @src: The source text to be filled.
+ *
+ * The text is null-terminated, but may also contain null characters of its own,
+ * so its size is kept as well. A source that can't be sized (a pipe) is read until its end.
+ *
+ * Return: 1 on success, 0 on read error, 2 on memory error.
+ */
+int readSource(FILE *fp, source_text *src)
+{
+	long size;
+
+	src -> text = NULL;
+	src -> size = 0;
+
+	/* find the size of the file */
+	if (fseek(fp, 0, SEEK_END) != 0 || (size = ftell(fp)) < 0 || fseek(fp, 0, SEEK_SET) != 0) {
+		return readStream(fp, src); /* not a regular file */
+	}
+
+	src -> text = (char *) malloc(size + 1);
+	if (src -> text == NULL) {
+		return 2; /* memory error */
+	}
+
+	src -> size = fread(src -> text, 1, size, fp);
+	src -> text[src -> size] = '\0';
+	return 1;
+}
+
+
+/*
+ * nextLine - Gives out a view of the next line in a text.
+ * @text: The text.
+ * @size: The num of characters in the text.
+ * @pos: The reading position in the text, it's advanced to the start of the next line.
+ * @view: The line view to be filled.
+ *
+ * The view is not null-terminated: it's the "length" characters from "start",
+ * followed by the '\n' (included in "raw_length") unless it's the last line of the text.
+ *
+ * Return: 1 if a line was found, 0 at the end of the text.
+ */
+int nextLine(const char *text, int size, int *pos, line_view *view)
+{
+	const char *end;
+
+	if (*pos >= size) {
+		return 0; /* end of the text */
+	}
+
+	view -> start = text + *pos;
+	end = memchr(view -> start, '\n', size - *pos);
+	if (end == NULL) {
+		view -> length = view -> raw_length = size - *pos; /* last line, without a '\n' */
+	} else {
+		view -> length = end - view -> start;
+		view -> raw_length = view -> length + 1;
+	}
+
+	*pos += view -> raw_length;
+	return 1;
+}
+
+
+/*
+ * freeSource - Frees a source text.
+ * @src: The source text.
+ */
+void freeSource(source_text *src)
+{
+	free(src -> text);
+	src -> text = NULL;
+	src -> size = 0;
+}
@@ -0,0 +1,591 @@
+/*
+ * watch.c - This file contains the watch mode of the assembler ("--watch").
+ * Instead of exiting once the input files are assembled, the assembler keeps running and assembles
+ * again every file whose source (or one of the macro libraries it includes) was changed. The directories
+ * of the sources and of their libraries are watched by inotify, where it's not available the sources are
+ * checked every WATCH_POLL_MS milliseconds.
+ * Editors may also ask for files to be assembled through a local socket ("--socket=PATH"): a client
+ * writes the names of the files, and reads back their diagnostics followed by a status line per file.
+ * All the files are assembled in a single context that lives as long as the watch, so the blocks of
+ * its arena and its buffers are allocated once and reused by every rebuild.
+ */
+
+#define _XOPEN_SOURCE 700 /* st_mtim, sigaction */
+#include <errno.h>
+#include <signal.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+#include "assembler/assembler.h"
+#include "pre_processing/pre_assembler.h"
+#include "watch.h"
+
+
+#define WATCH_POLL_MS 250 /* how often the sources are checked when there's no inotify */
+#define WATCH_REQUEST_SIZE 1024 /* max num of characters in a request of a socket client */
+#define WATCH_CLIENT_TIMEOUT 2 /* num of seconds a socket client has to send its request */
+
+/* this struct defines a macro library included by a watched source */
+typedef struct {
+	char name[LIBRARY_NAME_SIZE + 1];
+	struct stat st; /* the status of the library when the source was last checked (all zeros when it's missing) */
+} watched_library;
+
+/* this struct defines a watched source file */
+typedef struct {
+	char *name; /* name of the file, without ".as" */
+	int index; /* index of the file in the command line */
+	struct stat st; /* the status of the source when it was last checked (all zeros when it's missing) */
+	char key[CACHE_KEY_SIZE + 1]; /* the content key of the source that was assembled last, "" if none */
+	watched_library *libraries; /* the libraries of its ".include" lines */
+	int num_of_libraries;
+	int libraries_capacity;
+} watched_file;
+
+static volatile sig_atomic_t stop_watch = 0;
+static int notify_fd = -1; /* the inotify descriptor, -1 when the sources are polled */
+
+
+/*
+ * onStopSignal - Stops the watch (SIGINT, SIGTERM).
+ */
+static void onStopSignal(int sig)
+{
+	stop_watch = 1;
+}
+
+
+/*
+ * statFile - Gets the status of a file.
+ * @name: Name of the file.
+ * @st: The status to be filled, all zeros when the file is missing.
+ */
+static void statFile(const char *name, struct stat *st)
+{
+	if (stat(name, st) != 0) {
+		memset(st, 0, sizeof(struct stat)); /* missing */
+	}
+}
+
+
+/*
+ * sameStatus - Checks whether two statuses of a file are the same.
+ *
+ * Return: 1 if they're the same, 0 if not.
+ */
+static int sameStatus(const struct stat *a, const struct stat *b)
+{
+	return a -> st_ino == b -> st_ino && a -> st_dev == b -> st_dev && a -> st_size == b -> st_size &&
+		a -> st_mtim.tv_sec == b -> st_mtim.tv_sec && a -> st_mtim.tv_nsec == b -> st_mtim.tv_nsec;
+}
+
+
+/*
+ * watchDirectory - Watches the directory of a file by inotify.
+ * @fd: The inotify descriptor.
+ * @file_name: Name of the file.
+ *
+ * Return: 1 on success, 0 on error.
+ */
+static int watchDirectory(int fd, const char *file_name)
+{
+#ifdef __linux__
+	char dir[256 + 4];
+	char *slash;
+
+	snprintf(dir, sizeof(dir), "%s", file_name); /* longer names are rejected by the assembler */
+	slash = strrchr(dir, '/');
+	if (slash == NULL) {
+		strcpy(dir, ".");
+	} else {
+		slash[slash == dir] = '\0'; /* keep the '/' of the root directory */
+	}
+
+	/* editors either write the file in place or rename a new file over it */
+	return inotify_add_watch(fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE | IN_ATTRIB) != -1;
+#else
+	return 0;
+#endif
+}
+
+
+/*
+ * recordLibraries - Records the macro libraries that a watched source includes, and their status.
+ * @w: The watched file.
+ * @fp: File pointer to the source, it's rewound to the start of the file.
+ *
+ * The directory of every library is watched too (a directory that can't be watched is left to the
+ * checks of the sources). NOTICE: a library that can't be recorded (no memory) isn't checked.
+ */
+static void recordLibraries(watched_file *w, FILE *fp)
+{
+	char library_name[LIBRARY_NAME_SIZE + 1];
+	source_text src;
+	int read_err;
+	int pos = 0;
+
+	w -> num_of_libraries = 0;
+	read_err = readSource(fp, &src);
+	rewind(fp);
+	if (read_err != 1) {
+		free(src.text);
+		return;
+	}
+
+	while (nextInclude(&src, &pos, library_name))
+	{
+		watched_library *library;
+
+		if (w -> num_of_libraries == w -> libraries_capacity) {
+			int new_capacity = (w -> libraries_capacity == 0) ? 4 : w -> libraries_capacity * 2;
+			watched_library *new_libraries = (watched_library *) realloc(w -> libraries, new_capacity * sizeof(watched_library));
+			if (new_libraries == NULL) {
+				break;
+			}
+			w -> libraries = new_libraries;
+			w -> libraries_capacity = new_capacity;
+		}
+		library = &w -> libraries[w -> num_of_libraries++];
+		strcpy(library -> name, library_name);
+		statFile(library_name, &library -> st);
+		if (notify_fd != -1) {
+			watchDirectory(notify_fd, library_name);
+		}
+	}
+	freeSource(&src);
+}
+
+
+/*
+ * librariesChanged - Checks whether the status of one of the libraries of a watched source has changed.
+ * @w: The watched file.
+ *
+ * Return: 1 if a library changed, 0 if not.
+ */
+static int librariesChanged(watched_file *w)
+{
+	struct stat st;
+	int i;
+
+	for (i = 0; i < w -> num_of_libraries; i++) {
+		statFile(w -> libraries[i].name, &st);
+		if (!sameStatus(&st, &w -> libraries[i].st)) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+
+/*
+ * sourceChanged - Checks whether the source of a watched file was changed since it was last checked.
+ * @w: The watched file.
+ *
+ * A change to one of the macro libraries of the source counts as a change to the source. A source whose
+ * status changed but whose content is the same (a touch, or an editor saving it unchanged) is not counted
+ * as a change.
+ *
+ * Return: 1 if the source changed, 0 if not.
+ */
+static int sourceChanged(watched_file *w)
+{
+	char src_filename[256 + 4];
+	char key[CACHE_KEY_SIZE + 1] = "";
+	struct stat st;
+	FILE *fp;
+
+	snprintf(src_filename, sizeof(src_filename), "%s.as", w -> name);
+	statFile(src_filename, &st);
+	if (sameStatus(&st, &w -> st) && librariesChanged(w) == 0) {
+		return 0;
+	}
+	w -> st = st;
+
+	/* compare the content (with the libraries) with the source that was assembled last */
+	fp = fopen(src_filename, "r");
+	if (fp != NULL) {
+		if (cacheKey(fp, key) != 1) {
+			key[0] = '\0'; /* assembled anyway, the error is reported by the assembler */
+		}
+		recordLibraries(w, fp);
+		fclose(fp);
+	} else {
+		w -> num_of_libraries = 0;
+	}
+	if (key[0] != '\0' && strcmp(key, w -> key) == 0) {
+		return 0;
+	}
+	strcpy(w -> key, key);
+	return 1;
+}
+
+
+/*
+ * writeAll - Writes a whole buffer to a socket client.
+ * @fd: The client.
+ * @text: The buffer.
+ * @length: The num of characters to be written.
+ *
+ * A client that went away is ignored.
+ */
+static void writeAll(int fd, const char *text, int length)
+{
+	while (length > 0) {
+		ssize_t written = write(fd, text, length);
+		if (written <= 0) {
+			if (written < 0 && errno == EINTR) {
+				continue;
+			}
+			return;
+		}
+		text += written;
+		length -= written;
+	}
+}
+
+
+/*
+ * replyClient - Writes the diagnostics of the current context and the status of a file to a socket client.
+ * @client: The client.
+ * @name: Name of the file, without ".as".
+ * @status: The status of the file ("ok", "error", ...).
+ */
+static void replyClient(int client, const char *name, const char *status)
+{
+	text_buffer diagnostics = {NULL, 0, 0};
+
+	/* the diagnostics in the format of "--diagnostics" */
+	if (renderLog(Ctx, &diagnostics) == 1 && diagnostics.size > 0) {
+		writeAll(client, diagnostics.text, diagnostics.size);
+	}
+	free(diagnostics.text);
+
+	writeAll(client, name, strlen(name));
+	writeAll(client, ": ", 2);
+	writeAll(client, status, strlen(status));
+	writeAll(client, "\n", 1);
+}
+
+
+/*
+ * rebuild - Assembles a single file, and prints its diagnostics.
+ * @name: Name of the file, without ".as".
+ * @index: Index of the file in the command line.
+ * @assemble: Assembles a single file in the current context.
+ * @client: A socket client that gets the diagnostics and the status of the file too, -1 if none.
+ *
+ * Return: The result of assembling the file (FILE_).
+ */
+static int rebuild(char *name, int index, assemble_func assemble, int client)
+{
+	static const char *status[] = {"unreadable", "ok", "fatal", "cached", "error"};
+	int result = assemble(name, index);
+
+	if (client != -1) {
+		replyClient(client, name, status[result]);
+	}
+	flushLog(Ctx);
+	if (STATS_FORMAT != STATS_OFF && result != FILE_UNREADABLE && result != FILE_FATAL) {
+		printFileStats(name, &Ctx -> stats);
+	}
+	freeOutdatedLibraries(); /* the file is done, no file uses them anymore */
+	return result;
+}
+
+
+/*
+ * openSocket - Creates the local socket that requests are accepted on.
+ * @path: The path of the socket.
+ *
+ * A socket that was left at the path by an earlier watch is replaced, any other file is not.
+ *
+ * Return: The listening socket, -1 on error.
+ */
+static int openSocket(const char *path)
+{
+	struct sockaddr_un addr;
+	struct stat st;
+	int fd;
+
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		return -1; /* path too long */
+	}
+	if (stat(path, &st) == 0 && S_ISSOCK(st.st_mode)) {
+		unlink(path);
+	}
+
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd == -1) {
+		return -1;
+	}
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+	if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) != 0 || listen(fd, 8) != 0) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+
+/*
+ * requestedFile - Checks a file name that a socket client asks for.
+ * @name: The name, without ".as".
+ * @files: The watched files.
+ * @num_of_files: The num of watched files.
+ *
+ * Only the watched files are assembled for a client, or when no file is watched ("--socket" alone),
+ * the files of the working directory.
+ *
+ * Return: The index of the file in the command line (0 when no file is watched), -1 if it isn't assembled.
+ */
+static int requestedFile(const char *name, watched_file *files, int num_of_files)
+{
+	int i;
+
+	/* a watched file keeps its index, and isn't assembled again for the same change */
+	for (i = 0; i < num_of_files; i++) {
+		if (strcmp(files[i].name, name) == 0) {
+			sourceChanged(&files[i]);
+			return files[i].index;
+		}
+	}
+	if (num_of_files == 0 && strlen(name) < 256 && strchr(name, '/') == NULL) {
+		return 0;
+	}
+	return -1;
+}
+
+
+/*
+ * serveClient - Accepts a socket client, and assembles the files it asks for.
+ * @listen_fd: The listening socket.
+ * @files: The watched files.
+ * @num_of_files: The num of watched files.
+ * @assemble: Assembles a single file in the current context.
+ *
+ * The request is a single line of whitespace separated file names (without ".as"), the reply is the
+ * diagnostics of every file followed by "<name>: ok|error|cached|unreadable|fatal", and then the
+ * connection is closed. A name that isn't assembled (see requestedFile) gets an "error" status, and
+ * a request never stops the watch: a fatal file only ends the request.
+ */
+static void serveClient(int listen_fd, watched_file *files, int num_of_files, assemble_func assemble)
+{
+	char request[WATCH_REQUEST_SIZE + 1];
+	struct timeval timeout;
+	int length = 0;
+	int fatal = 0;
+	char *name;
+	int client;
+
+	client = accept(listen_fd, NULL, NULL);
+	if (client == -1) {
+		return;
+	}
+	timeout.tv_sec = WATCH_CLIENT_TIMEOUT;
+	timeout.tv_usec = 0;
+	setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+	/* read the request line */
+	while (length < WATCH_REQUEST_SIZE) {
+		ssize_t n = read(client, request + length, WATCH_REQUEST_SIZE - length);
+		if (n <= 0) {
+			break;
+		}
+		length += n;
+		if (memchr(request + length - n, '\n', n) != NULL) {
+			break;
+		}
+	}
+	request[length] = '\0';
+
+	for (name = strtok(request, " \t\r\n"); name != NULL && fatal == 0; name = strtok(NULL, " \t\r\n")) {
+		int index = requestedFile(name, files, num_of_files);
+
+		if (index == -1) {
+			Ctx -> file_name = name;
+			diagPrintf(DIAG_FILE_NAME, 0, "\nERROR: in file \"%s\", the file isn't watched, so it can't be requested.\n", name);
+			replyClient(client, name, "error");
+			flushLog(Ctx);
+			continue;
+		}
+		fatal = (rebuild(name, index, assemble, client) == FILE_FATAL);
+	}
+
+	close(client);
+}
+
+
+/*
+ * drainEvents - Reads all the waiting inotify events, only the wakeup matters.
+ * @fd: The inotify descriptor (non-blocking).
+ */
+static void drainEvents(int fd)
+{
+	char events[4096];
+	while (read(fd, events, sizeof(events)) > 0) ;
+}
+
+
+/*
+ * watchDirectories - Watches the directories of the sources by inotify.
+ * @files: The watched files.
+ * @num_of_files: The num of watched files.
+ *
+ * Return: The inotify descriptor, -1 when inotify is not available (the sources are polled).
+ */
+static int watchDirectories(watched_file *files, int num_of_files)
+{
+#ifdef __linux__
+	int fd = inotify_init1(IN_NONBLOCK);
+	int i;
+
+	if (fd == -1) {
+		return -1;
+	}
+	for (i = 0; i < num_of_files; i++) {
+		int j;
+
+		if (watchDirectory(fd, files[i].name) == 0) {
+			close(fd);
+			return -1;
+		}
+		for (j = 0; j < files[i].num_of_libraries; j++) {
+			if (watchDirectory(fd, files[i].libraries[j].name) == 0) {
+				close(fd);
+				return -1;
+			}
+		}
+	}
+	return fd;
+#else
+	return -1;
+#endif
+}
+
+
+/*
+ * watchFiles - Assembles the given files, and keeps assembling them again whenever they change.
+ * @names: The names of the files, without ".as".
+ * @num_of_files: The num of files (may be 0 with a socket).
+ * @socket_path: The path of the local socket requests are accepted on, NULL for none.
+ * @assemble: Assembles a single file in the current context.
+ *
+ * The watch goes on until the program gets SIGINT or SIGTERM.
+ *
+ * Return: 1 when the watch was stopped, 0 on error.
+ */
+int watchFiles(char **names, int num_of_files, const char *socket_path, assemble_func assemble)
+{
+	watched_file *files = (watched_file *) calloc(num_of_files + 1, sizeof(watched_file));
+	asm_context *ctx = newContext(1);
+	struct sigaction action;
+	int listen_fd = -1;
+	int fatal = 0;
+	int i;
+
+	if (files == NULL || ctx == NULL) {
+		printf("\nMEMORY ERROR: unable to create the assembler context. Exiting program.\n");
+		free(files);
+		freeContext(ctx);
+		return 0;
+	}
+	Ctx = ctx;
+
+	if (socket_path != NULL) {
+		listen_fd = openSocket(socket_path);
+		if (listen_fd == -1) {
+			printf("\nERROR: unable to listen on socket \"%s\".\n", socket_path);
+			free(files);
+			freeContext(ctx);
+			Ctx = NULL;
+			return 0;
+		}
+	}
+
+	/* stop cleanly on SIGINT and SIGTERM, and never die by a client that went away */
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = onStopSignal;
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+	action.sa_handler = SIG_IGN;
+	sigaction(SIGPIPE, &action, NULL);
+
+	/* assemble all the files once */
+	for (i = 0; i < num_of_files && fatal == 0; i++) {
+		files[i].name = names[i];
+		files[i].index = i + 1;
+		sourceChanged(&files[i]);
+		fatal = (rebuild(files[i].name, files[i].index, assemble, -1) == FILE_FATAL);
+	}
+
+	notify_fd = watchDirectories(files, num_of_files);
+	if (fatal == 0) {
+		printf("Watching %d files for changes (%s)%s%s, Ctrl-C to stop.\n", num_of_files, notify_fd != -1 ? "inotify" : "polling",
+			socket_path != NULL ? ", requests on " : "", socket_path != NULL ? socket_path : "");
+		fflush(stdout);
+	}
+
+	while (stop_watch == 0 && fatal == 0)
+	{
+		struct pollfd fds[2];
+		int num_of_fds = 0;
+		int ready;
+
+		if (notify_fd != -1) {
+			fds[num_of_fds].fd = notify_fd;
+			fds[num_of_fds++].events = POLLIN;
+		}
+		if (listen_fd != -1) {
+			fds[num_of_fds].fd = listen_fd;
+			fds[num_of_fds++].events = POLLIN;
+		}
+
+		ready = poll(fds, num_of_fds, (notify_fd != -1) ? -1 : WATCH_POLL_MS);
+		if (ready < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			break;
+		}
+
+		/* every change to the directories (or every poll) checks all the sources */
+		if (notify_fd != -1 && (fds[0].revents & POLLIN)) {
+			drainEvents(notify_fd);
+		}
+		if (notify_fd == -1 || (fds[0].revents & POLLIN)) {
+			for (i = 0; i < num_of_files && fatal == 0; i++) {
+				if (sourceChanged(&files[i])) {
+					fatal = (rebuild(files[i].name, files[i].index, assemble, -1) == FILE_FATAL);
+				}
+			}
+		}
+
+		if (listen_fd != -1 && (fds[num_of_fds - 1].revents & POLLIN) && fatal == 0) {
+			serveClient(listen_fd, files, num_of_files, assemble);
+		}
+	}
+
+	if (notify_fd != -1) {
+		close(notify_fd);
+		notify_fd = -1;
+	}
+	if (listen_fd != -1) {
+		close(listen_fd);
+		unlink(socket_path);
+	}
+	for (i = 0; i < num_of_files; i++) {
+		free(files[i].libraries);
+	}
+	free(files);
+	freeContext(ctx);
+	Ctx = NULL;
+	return fatal == 0;
+}
@@ -0,0 +1,17 @@
+/*
+ * watch.h - Header file of the watch mode of the assembler ("--watch")
+ * This file contains the results of assembling a single file, shared by the main function and the
+ * watch mode, and the declaration of the watch mode itself.
+ */
+
+/* results of assembling a single file */
+#define FILE_UNREADABLE 0 /* the input file couldn't be opened */
+#define FILE_DONE 1 /* the file was assembled successfully */
+#define FILE_FATAL 2 /* memory error or invalid file name, the program exits */
+#define FILE_CACHED 3 /* the output files were copied from the build cache */
+#define FILE_ERRORS 4 /* the file was assembled, with errors */
+
+/* assembles a single file in the current context (the name without ".as", its index in the command line) */
+typedef int (*assemble_func)(char*, int);
+
+int watchFiles(char**, int, const char*, assemble_func);